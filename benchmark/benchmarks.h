@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include <libs/options.h>
+#include <statistics_service/packets_handler.h>
+
+template < typename Function >
+std::chrono::duration< double > measure( Function&& function )
+{
+	const auto begin = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::steady_clock::now() - begin;
+}
+
+// Packets with full tops and neighbours of random users and amounts, the same for every run.
+std::vector< Packet > randomPackets( const size_t count );
+
+void protocolBenchmark( const Options& options );
+void snapshotBenchmark( const Options& options );
+void receiversBenchmark( const Options& options );
+void packetsBenchmark( const Options& options );
+void usersBenchmark( const Options& options );
+void checkpointBenchmark( const Options& options );
+void handlersBenchmark( const Options& options );
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <sys/stat.h>
+
+#include <statistics_service/events_handler.h>
+#include <statistics_service/packets_handler.h>
+
+#include "benchmarks.h"
+
+void checkpointBenchmark( const Options& options )
+{
+	using namespace std::chrono_literals;
+
+	const auto users = options.number( "users", 10000000 );
+	const auto deals = options.number( "deals-per-user", 2 );
+	const std::string path( options.value( "path", "checkpoint.bin" ) );
+
+	PacketsHandler packets_handler( "127.0.0.1", static_cast< uint16_t >( options.number( "port", 9999 ) ) );
+	EventsHandlerConfig config;
+	config.dense_users = options.has( "dense" ) ? users : 0;
+	config.checkpoint_path = path;
+	config.checkpoint_period = std::chrono::hours( 24 );
+	std::remove( path.c_str() );
+
+	std::mt19937_64 random( 42 );
+	auto events_handler = std::make_unique< EventsHandler >( packets_handler, config );
+	const auto replay_time = measure( [&] {
+		for ( size_t i = 0; i < users; ++i ) {
+			events_handler->handle( UserRegisteredEvent( static_cast< Event::User >( i ), "user" + std::to_string( i ) ) );
+		}
+		// Deals stay within one minute: nothing drains the broadcasts of packets_handler here.
+		for ( size_t i = 0; i < users * deals; ++i ) {
+			const auto user = static_cast< Event::User >( random() % users );
+			events_handler->handle( UserDealWonEvent( user, std::chrono::nanoseconds( 1us ) * i, static_cast< int64_t >( random() % 1000 ) ) );
+		}
+	} );
+	const auto write_time = measure( [&] { events_handler.reset(); } );
+
+	struct stat status{};
+	stat( path.c_str(), &status );
+
+	const auto restore_time = measure( [&] { events_handler = std::make_unique< EventsHandler >( packets_handler, config ); } );
+
+	std::cout << "users: " << users << " deals: " << users * deals << ( config.dense_users > 0 ? " dense" : "" ) << "\n";
+	std::cout << "  replay of parsed events: " << replay_time.count() << " s\n";
+	std::cout << "  checkpoint: " << write_time.count() << " s, " << status.st_size / ( 1024 * 1024 ) << " MiB\n";
+	std::cout << "  startup from checkpoint: " << restore_time.count() << " s\n";
+}
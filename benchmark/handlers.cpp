@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <libs/event_generator.h>
+#include <statistics_service/events_handler.h>
+#include <statistics_service/packets_handler.h>
+
+#include "benchmarks.h"
+
+namespace
+{
+// One CSV row per measurement, so that runs of different releases can be compared by a script.
+void report( const std::string_view name,
+             const size_t users,
+             const uint64_t connected_percent,
+             const size_t operations,
+             const std::chrono::duration< double > time )
+{
+	const auto nanoseconds = operations > 0 ? time.count() * 1e9 / static_cast< double >( operations ) : 0.0;
+	std::cout << name << "," << users << "," << connected_percent << "," << operations << "," << time.count() << ","
+	          << nanoseconds << std::endl;
+}
+
+void eventsBenchmark( const Options& options, const size_t users, const uint64_t connected_percent )
+{
+	using namespace std::chrono_literals;
+
+	const auto deals = options.number( "deals", 1000000 );
+	const auto broadcasts = std::max< uint64_t >( 1, options.number( "broadcasts", 3 ) );
+	const auto weeks = std::max< uint64_t >( 1, options.number( "weeks", 100 ) );
+
+	// Direct packets are serialized and sent on this thread, without a processing thread to drain a queue.
+	PacketsHandlerConfig packets_config;
+	packets_config.batch_size = options.number( "batch", 64 );
+	packets_config.direct = true;
+	PacketsHandler packets_handler( "127.0.0.1", static_cast< uint16_t >( options.number( "port", 9999 ) ), packets_config );
+
+	// Minute broadcasts only start on broadcast(), so that deals measure addUserAmount() alone.
+	EventsHandlerConfig events_config;
+	events_config.timed_broadcasts = true;
+	events_config.dense_users = options.has( "dense" ) ? users : 0;
+	EventsHandler events_handler( packets_handler, events_config );
+
+	std::mt19937_64 random( 42 );
+	for ( size_t i = 0; i < users; ++i ) {
+		const auto user = static_cast< Event::User >( i );
+		events_handler.handle( UserRegisteredEvent( user, "user" + std::to_string( i ) ) );
+	}
+
+	std::vector< Event::User > connected;
+	for ( size_t i = 0; i < users; ++i ) {
+		if ( random() % 100 < connected_percent ) {
+			connected.push_back( static_cast< Event::User >( i ) );
+		}
+	}
+
+	// Every deal of a week falls before its first full day, whatever the count.
+	const auto deal_step = std::chrono::nanoseconds( 24h ) / std::max< uint64_t >( 1, deals );
+	const auto add_time = measure( [&] {
+		for ( size_t i = 0; i < deals; ++i ) {
+			const auto user = static_cast< Event::User >( random() % users );
+			events_handler.handle( UserDealWonEvent( user, deal_step * i, static_cast< int64_t >( random() % 2001 ) - 1000 ) );
+		}
+	} );
+	report( "add_user_amount", users, connected_percent, deals, add_time );
+
+	// Connecting sends the user its statistics straight away.
+	const auto statistic_time = measure( [&] {
+		for ( const auto user : connected ) {
+			events_handler.handle( UserConnectedEvent( user ) );
+		}
+		packets_handler.flush();
+	} );
+	report( "user_statistic", users, connected_percent, connected.size(), statistic_time );
+
+	const auto send_time = measure( [&] {
+		for ( size_t i = 0; i < broadcasts; ++i ) {
+			events_handler.broadcast();
+		}
+		packets_handler.flush();
+	} );
+	report( "send_packets", users, connected_percent, broadcasts, send_time );
+
+	// A deal late in the week followed by one early in the next starts a new week.
+	std::chrono::duration< double > clear_time{};
+	for ( size_t i = 0; i < weeks; ++i ) {
+		const auto user = static_cast< Event::User >( random() % users );
+		const auto week = std::chrono::nanoseconds( 7 * 24h ) * ( i + 1 );
+		events_handler.handle( UserDealWonEvent( user, week - 1min, 1 ) );
+		clear_time += measure( [&] { events_handler.handle( UserDealWonEvent( user, week, 1 ) ); } );
+	}
+	report( "clear_statistics", users, connected_percent, weeks, clear_time );
+}
+
+void protocolRows( const Options& options )
+{
+	const auto count = options.number( "events", 1000000 );
+
+	std::vector< std::string > text_events;
+	std::vector< std::string > binary_events;
+	text_events.reserve( count );
+	binary_events.reserve( count );
+
+	std::chrono::nanoseconds currentTime = std::chrono::nanoseconds::zero();
+	EventGenerator eventGenerator;
+	std::string buffer( std::max( Event::max_binary_size, Packet::max_text_size ), '\0' );
+	for ( uint64_t i = 0; i < count; ++i ) {
+		const auto event = eventGenerator.generateEvent( currentTime );
+		if ( const auto* dealWonEvent = event.get< UserDealWonEvent >(); dealWonEvent ) {
+			currentTime = dealWonEvent->time();
+		}
+
+		std::ostringstream ss;
+		ss << event;
+		text_events.push_back( ss.str() );
+		binary_events.emplace_back( buffer.data(), event.toBinary( buffer.data(), buffer.size() ) );
+	}
+
+	size_t parsed = 0;
+	report( "parse_text", 0, 0, count, measure( [&] {
+		        for ( const auto& data : text_events ) {
+			        parsed += Event::fromText( data ) ? 1 : 0;
+		        }
+	        } ) );
+	report( "parse_binary", 0, 0, count, measure( [&] {
+		        for ( const auto& data : binary_events ) {
+			        parsed += Event::fromBinary( data ) ? 1 : 0;
+		        }
+	        } ) );
+
+	const auto packets = randomPackets( 1024 );
+
+	size_t bytes = 0;
+	report( "packet_text", 0, 0, count, measure( [&] {
+		        for ( size_t i = 0; i < count; ++i ) {
+			        bytes += packets[ i % packets.size() ].toText( buffer.data(), buffer.size() );
+		        }
+	        } ) );
+	report( "packet_binary", 0, 0, count, measure( [&] {
+		        for ( size_t i = 0; i < count; ++i ) {
+			        bytes += packets[ i % packets.size() ].toBinary( buffer.data(), buffer.size() );
+		        }
+	        } ) );
+
+	// Keeps the loops above from being optimized away.
+	std::cerr << "parsed " << parsed << " events, serialized " << bytes << " bytes\n";
+}
+}
+
+void handlersBenchmark( const Options& options )
+{
+	const auto min_users = std::max< uint64_t >( 1, options.number( "min-users", 1000 ) );
+	const auto max_users = options.number( "max-users", 10000000 );
+	const auto connected_percent = options.number( "connected-percent", 10 );
+
+	std::cout << "benchmark,users,connected_percent,operations,seconds,ns_per_operation" << std::endl;
+	protocolRows( options );
+	for ( auto users = min_users; users <= max_users; users *= 10 ) {
+		eventsBenchmark( options, users, connected_percent );
+	}
+}
@@ -0,0 +1,38 @@
+#include <iostream>
+
+#include "benchmarks.h"
+
+int main( int argc, char* argv[] )
+{
+	const Options options( argc, argv );
+	const auto& arguments = options.positional();
+	const auto name = arguments.empty() ? std::string_view( "protocol" ) : arguments[ 0 ];
+
+	if ( "protocol" == name ) {
+		protocolBenchmark( options );
+	}
+	else if ( "snapshot" == name ) {
+		snapshotBenchmark( options );
+	}
+	else if ( "receivers" == name ) {
+		receiversBenchmark( options );
+	}
+	else if ( "packets" == name ) {
+		packetsBenchmark( options );
+	}
+	else if ( "users" == name ) {
+		usersBenchmark( options );
+	}
+	else if ( "checkpoint" == name ) {
+		checkpointBenchmark( options );
+	}
+	else if ( "handlers" == name ) {
+		handlersBenchmark( options );
+	}
+	else {
+		std::cerr << "Unknown benchmark " << name << ".\n";
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <statistics_service/packets_handler.h>
+
+#include "benchmarks.h"
+
+namespace
+{
+// Formatting through std::ostream the way packets were serialized before Packet::toText().
+std::string streamText( const Packet& packet )
+{
+	std::ostringstream out;
+	auto add_user_to_packet = [&out]( const StatisticsEntry& entry ) {
+		out << "\tid: " << entry.id << " amount: " << entry.amount << "\n";
+	};
+
+	out << "id: " << packet.user << " position: " << packet.position << "\n";
+	out << "top: \n";
+	std::for_each( packet.top.entries.cbegin(), packet.top.entries.cend(), add_user_to_packet );
+	out << "near: \n";
+	std::for_each( packet.near.cbegin(), packet.near.cend(), add_user_to_packet );
+	return out.str();
+}
+}
+
+std::vector< Packet > randomPackets( const size_t count )
+{
+	std::mt19937_64 random( 42 );
+	std::uniform_int_distribution< int64_t > amounts( -1000000, 100000000 );
+	std::uniform_int_distribution< Event::User > users( 1, 1000000 );
+
+	std::vector< Packet > packets( count );
+	for ( auto& packet : packets ) {
+		std::vector< StatisticsEntry > entries( TopStatistic::capacity + 2 * Packet::neighbors_count + 1 );
+		for ( auto& entry : entries ) {
+			entry = {amounts( random ), users( random )};
+		}
+		packet.user = users( random );
+		packet.position = static_cast< size_t >( users( random ) );
+		packet.top.version = random();
+		packet.top.entries.assign( entries.cbegin(), TopStatistic::capacity );
+		packet.near.assign( entries.cbegin() + TopStatistic::capacity, entries.size() - TopStatistic::capacity );
+	}
+	return packets;
+}
+
+void packetsBenchmark( const Options& options )
+{
+	const auto count = options.number( "packets", 1000000 );
+
+	const auto packets = randomPackets( 1024 );
+
+	std::vector< char > buffer( std::max( Packet::max_text_size, Packet::max_binary_size ) );
+	size_t mismatches = 0;
+	for ( const auto& packet : packets ) {
+		const auto text = streamText( packet );
+		const auto size = packet.toText( buffer.data(), buffer.size() );
+		mismatches += std::string_view( buffer.data(), size ) == text ? 0 : 1;
+	}
+
+	size_t bytes = 0;
+	const auto stream_time = measure( [&] {
+		for ( size_t i = 0; i < count; ++i ) {
+			bytes += streamText( packets[ i % packets.size() ] ).size();
+		}
+	} );
+	const auto text_time = measure( [&] {
+		for ( size_t i = 0; i < count; ++i ) {
+			bytes += packets[ i % packets.size() ].toText( buffer.data(), buffer.size() );
+		}
+	} );
+	const auto binary_time = measure( [&] {
+		for ( size_t i = 0; i < count; ++i ) {
+			bytes += packets[ i % packets.size() ].toBinary( buffer.data(), buffer.size() );
+		}
+	} );
+
+	std::cout << "packets: " << count << " text mismatches: " << mismatches << " bytes: " << bytes << "\n";
+	std::cout << "ostringstream: " << count / stream_time.count() << " packets/s\n";
+	std::cout << "to_chars text: " << count / text_time.count() << " packets/s (" << stream_time / text_time << "x)\n";
+	std::cout << "binary: " << count / binary_time.count() << " packets/s (" << stream_time / binary_time << "x)\n";
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <libs/event_generator.h>
+
+#include "benchmarks.h"
+
+void protocolBenchmark( const Options& options )
+{
+	const auto count = options.number( "events", 1000000 );
+
+	std::vector< std::string > text_events;
+	std::vector< std::string > binary_events;
+	text_events.reserve( count );
+	binary_events.reserve( count );
+
+	std::chrono::nanoseconds currentTime = std::chrono::nanoseconds::zero();
+	EventGenerator eventGenerator;
+	std::string buffer( Event::max_binary_size, '\0' );
+	for ( uint64_t i = 0; i < count; ++i ) {
+		const auto event = eventGenerator.generateEvent( currentTime );
+		if ( const auto* dealWonEvent = event.get< UserDealWonEvent >(); dealWonEvent ) {
+			currentTime = dealWonEvent->time();
+		}
+
+		std::ostringstream ss;
+		ss << event << "\n";
+		text_events.push_back( ss.str() );
+		binary_events.emplace_back( buffer.data(), event.toBinary( buffer.data(), buffer.size() ) );
+	}
+
+	auto parse = []( const auto& events, auto&& decode, size_t& parsed ) {
+		for ( const auto& data : events ) {
+			parsed += decode( data ) ? 1 : 0;
+		}
+	};
+
+	size_t text_parsed = 0;
+	size_t binary_parsed = 0;
+	const auto text_time = measure( [&] { parse( text_events, Event::fromText, text_parsed ); } );
+	const auto binary_time = measure( [&] { parse( binary_events, Event::fromBinary, binary_parsed ); } );
+
+	std::cout << "events: " << count << " parsed text: " << text_parsed << " binary: " << binary_parsed << "\n";
+	std::cout << "text: " << count / text_time.count() << " events/s\n";
+	std::cout << "binary: " << count / binary_time.count() << " events/s\n";
+	std::cout << "speedup: " << text_time / binary_time << "x\n";
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <libs/common.h>
+#include <libs/datagram_batch.h>
+#include <libs/event_generator.h>
+#include <statistics_service/receiver.h>
+
+#include "benchmarks.h"
+
+namespace
+{
+// Fills a batch with consecutive generated events, one per datagram.
+void fillBatch( DatagramBatch& batch, EventGenerator& generator, const bool binary )
+{
+	std::chrono::nanoseconds time = std::chrono::nanoseconds::zero();
+	for ( size_t i = 0; i < batch.capacity(); ++i ) {
+		auto event = generator.generateEvent( time );
+		while ( !event ) {
+			event = generator.generateEvent( time );
+		}
+		size_t size = 0;
+		if ( binary ) {
+			size = event.toBinary( batch.buffer( i ), batch.bufferSize() );
+		}
+		else {
+			std::ostringstream ss;
+			ss << event;
+			const auto text = ss.str();
+			size = std::min( text.size(), batch.bufferSize() );
+			std::copy_n( text.data(), size, batch.buffer( i ) );
+		}
+		batch.setDatagramSize( i, size );
+	}
+}
+}
+
+void receiversBenchmark( const Options& options )
+{
+	using namespace std::chrono_literals;
+
+	const auto max_receivers = std::max< size_t >( 1, options.number( "max-receivers", 4 ) );
+	const auto senders = std::max< size_t >( 1, options.number( "senders", 4 ) );
+	const auto batch_size = std::max< size_t >( 1, options.number( "batch", 32 ) );
+	const auto port = static_cast< uint16_t >( options.number( "port", 19000 ) );
+	const auto duration = std::chrono::milliseconds( options.number( "milliseconds", 1000 ) );
+	const bool binary = "binary" == options.value( "protocol", "binary" );
+	const bool io_uring = "uring" == options.value( "io", "socket" );
+
+	for ( size_t receivers_count = 1; receivers_count <= max_receivers; ++receivers_count ) {
+		std::vector< std::unique_ptr< Receiver > > receivers;
+		for ( size_t i = 0; i < receivers_count; ++i ) {
+			receivers.push_back( std::make_unique< Receiver >( port, binary, batch_size, io_uring, receivers_count > 1 ) );
+		}
+		const bool steered = receivers.front()->steerByUser( receivers_count );
+
+		struct rusage usage_before{};
+		getrusage( RUSAGE_SELF, &usage_before );
+
+		std::atomic< bool > stopped( false );
+		std::vector< uint64_t > received( receivers_count );
+		std::vector< std::thread > receive_threads;
+		for ( size_t i = 0; i < receivers_count; ++i ) {
+			receive_threads.emplace_back( [&receiver = *receivers[ i ], &stopped, &count = received[ i ]] {
+				receiver.run( stopped, [&count]( const Event& ) { ++count; } );
+			} );
+		}
+
+		std::atomic< bool > sending( true );
+		std::atomic< uint64_t > sent( 0 );
+		std::vector< std::thread > send_threads;
+		for ( size_t i = 0; i < senders; ++i ) {
+			send_threads.emplace_back( [&] {
+				const auto socket = createSocket();
+				const auto address = getRemoteSockaddr( "127.0.0.1", port );
+				EventGenerator generator;
+				DatagramBatch batch( batch_size, Event::max_binary_size );
+				fillBatch( batch, generator, binary );
+				uint64_t count = 0;
+				while ( sending.load() ) {
+					count += batch.send( socket, address, batch.capacity() );
+				}
+				sent += count;
+				close( socket );
+			} );
+		}
+
+		std::this_thread::sleep_for( duration );
+		sending.store( false );
+		for ( auto& thread : send_threads ) {
+			thread.join();
+		}
+		std::this_thread::sleep_for( 200ms );
+		stopped.store( true );
+		for ( auto& thread : receive_threads ) {
+			thread.join();
+		}
+
+		struct rusage usage_after{};
+		getrusage( RUSAGE_SELF, &usage_after );
+		const auto cpu_seconds = [] ( const struct rusage& usage ) {
+			return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1e6;
+		};
+
+		uint64_t total = 0;
+		uint64_t calls = 0;
+		for ( size_t i = 0; i < receivers_count; ++i ) {
+			total += received[ i ];
+			calls += receivers[ i ]->calls();
+		}
+		const auto seconds = std::chrono::duration< double >( duration ).count();
+		std::cout << "receivers: " << receivers_count << ( steered ? " (steered by user)" : "" )
+		          << ( receivers.front()->usesIoUring() ? " io_uring" : "" ) << " senders: " << senders
+		          << " sent: " << sent.load() / seconds << " datagrams/s received: " << total / seconds << " events/s ("
+		          << ( sent.load() ? 100.0 * total / sent.load() : 0.0 ) << "%)\n";
+		std::cout << "  receive calls per datagram: " << ( total ? static_cast< double >( calls ) / total : 0.0 )
+		          << " cpu: " << cpu_seconds( usage_after ) - cpu_seconds( usage_before ) << " s context switches: "
+		          << ( usage_after.ru_nvcsw + usage_after.ru_nivcsw ) - ( usage_before.ru_nvcsw + usage_before.ru_nivcsw ) << "\n";
+		for ( size_t i = 0; i < receivers_count; ++i ) {
+			std::cout << "  receiver " << i << ": " << received[ i ] << " events\n";
+		}
+	}
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <libs/thread_pool.h>
+#include <statistics_service/leaderboard.h>
+#include <statistics_service/leaderboard_snapshot.h>
+
+#include "benchmarks.h"
+
+namespace
+{
+bool samePackets( const Packet& lhs, const Packet& rhs )
+{
+	const auto same_entry = []( const StatisticsEntry& lhs, const StatisticsEntry& rhs ) {
+		return lhs.amount == rhs.amount && lhs.id == rhs.id;
+	};
+	return lhs.user == rhs.user && lhs.position == rhs.position
+	       && std::equal( lhs.near.cbegin(), lhs.near.cend(), rhs.near.cbegin(), rhs.near.cend(), same_entry );
+}
+}
+
+void snapshotBenchmark( const Options& options )
+{
+	const auto max_users = options.number( "max-users", 10000000 );
+	const auto connected_percent = options.number( "connected-percent", 100 );
+	const auto threads = options.number( "threads", std::max( 1u, std::thread::hardware_concurrency() ) );
+
+	ThreadPool pool( std::max< size_t >( 1, threads ) - 1 );
+	std::mt19937_64 random( 42 );
+	std::uniform_int_distribution< int64_t > amounts( -1000, 1000000 );
+
+	for ( size_t users = 100000; users <= max_users; users *= 10 ) {
+		Leaderboard leaderboard;
+		std::vector< Event::User > connected;
+		for ( size_t i = 0; i < users; ++i ) {
+			const auto user = static_cast< Event::User >( i );
+			leaderboard.addUser( user );
+			if ( random() % 4 != 0 ) {
+				leaderboard.addAmount( user, amounts( random ) );
+			}
+			if ( random() % 100 < connected_percent ) {
+				connected.push_back( user );
+			}
+		}
+
+		TopStatistic top;
+		std::vector< StatisticsEntry > window;
+		leaderboard.copy( 0, TopStatistic::capacity, std::back_inserter( window ) );
+		top.entries.assign( window.cbegin(), window.size() );
+
+		std::vector< Packet > tree_packets( connected.size() );
+		const auto tree_time = measure( [&] {
+			for ( size_t i = 0; i < connected.size(); ++i ) {
+				const auto entry = leaderboard.entry( connected[ i ] );
+				const auto rank = entry ? leaderboard.rank( *entry ) : leaderboard.size();
+				const auto first = rank > Packet::neighbors_count ? rank - Packet::neighbors_count : 0;
+
+				window.clear();
+				leaderboard.copy( first, std::min( rank + Packet::neighbors_count + 1, leaderboard.size() ), std::back_inserter( window ) );
+
+				auto& packet = tree_packets[ i ];
+				packet.user = connected[ i ];
+				packet.position = rank + 1;
+				packet.top = top;
+				packet.near.assign( window.cbegin(), window.size() );
+			}
+		} );
+
+		LeaderboardSnapshot snapshot;
+		const auto freeze_time = measure( [&] {
+			snapshot.top = top;
+			snapshot.entries.reserve( leaderboard.size() );
+			leaderboard.copyUnordered( std::back_inserter( snapshot.entries ) );
+			snapshot.connected.reserve( connected.size() );
+			for ( const auto user : connected ) {
+				snapshot.connected.emplace_back( user, leaderboard.entry( user ) );
+			}
+		} );
+		const auto rank_time = measure( [&] { snapshot.rank( pool ); } );
+
+		std::vector< Packet > snapshot_packets( connected.size() );
+		const auto slice_time = measure( [&] {
+			pool.parallelFor( connected.size(), 256, [&]( const size_t first, const size_t last ) {
+				for ( auto i = first; i < last; ++i ) {
+					snapshot_packets[ i ] = snapshot.packet( i );
+				}
+			} );
+		} );
+
+		size_t mismatches = 0;
+		for ( size_t i = 0; i < connected.size(); ++i ) {
+			mismatches += samePackets( tree_packets[ i ], snapshot_packets[ i ] ) ? 0 : 1;
+		}
+
+		const auto snapshot_time = freeze_time + rank_time + slice_time;
+		std::cout << "users: " << users << " connected: " << connected.size() << " threads: " << pool.concurrency()
+		          << " mismatches: " << mismatches << "\n";
+		std::cout << "  tree: " << tree_time.count() << " s\n";
+		std::cout << "  snapshot: " << snapshot_time.count() << " s (freeze " << freeze_time.count() << " s, rank "
+		          << rank_time.count() << " s, slice " << slice_time.count() << " s)\n";
+		std::cout << "  speedup: " << tree_time / snapshot_time << "x\n";
+	}
+}
@@ -0,0 +1,73 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <unistd.h>
+
+#include <libs/string_arena.h>
+#include <statistics_service/leaderboard.h>
+#include <statistics_service/users.h>
+
+#include "benchmarks.h"
+
+namespace
+{
+size_t residentBytes()
+{
+	size_t pages = 0;
+	size_t resident = 0;
+	std::ifstream( "/proc/self/statm" ) >> pages >> resident;
+	return resident * static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+}
+
+// The per-user state EventsHandler keeps: leaderboard, names and connected users.
+struct UsersState
+{
+	explicit UsersState( const size_t dense_users )
+	    : leaderboard( dense_users ), registered_users( dense_users ), connected_users( dense_users )
+	{
+	}
+
+	Leaderboard leaderboard;
+	StringArena names;
+	UserMap< StringArena::Span > registered_users;
+	UserSet connected_users;
+};
+}
+
+void usersBenchmark( const Options& options )
+{
+	const auto users = options.number( "users", 10000000 );
+	const auto active_percent = options.number( "active-percent", 10 );
+	const auto connected_percent = options.number( "connected-percent", 10 );
+
+	// Dense first: its arrays are unmapped when freed, the nodes of the hash maps stay in the heap.
+	for ( const auto dense : {true, false} ) {
+		std::mt19937_64 random( 42 );
+		const auto before = residentBytes();
+
+		auto state = std::make_unique< UsersState >( dense ? users : 0 );
+		const auto time = measure( [&] {
+			for ( size_t i = 0; i < users; ++i ) {
+				const auto user = static_cast< Event::User >( i );
+				state->registered_users.tryEmplace( user ).first = state->names.append( "user" + std::to_string( i ) );
+				state->leaderboard.addUser( user );
+				if ( random() % 100 < active_percent ) {
+					state->leaderboard.addAmount( user, static_cast< int64_t >( random() % 1000000 ) + 1 );
+				}
+				if ( random() % 100 < connected_percent ) {
+					state->connected_users.insert( user );
+				}
+			}
+		} );
+
+		const auto bytes = residentBytes() - before;
+		std::cout << ( dense ? "dense" : "sparse" ) << " users: " << users << " active: " << active_percent
+		          << "% connected: " << connected_percent << "%\n";
+		std::cout << "  memory: " << static_cast< double >( bytes ) / ( 1024 * 1024 ) << " MiB, "
+		          << static_cast< double >( bytes ) / static_cast< double >( users ) << " bytes/user\n";
+		std::cout << "  fill: " << time.count() << " s\n";
+	}
+}
@@ -1,11 +1,16 @@
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <charconv>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <signal.h>
@@ -13,88 +18,289 @@
 #include <unistd.h>
 
 #include <libs/common.h>
+#include <libs/datagram_batch.h>
 #include <libs/event_generator.h>
+#include <libs/latency_histogram.h>
+#include <libs/little_endian.h>
+#include <libs/options.h>
 
 static std::atomic< bool > stopped( false );
 
-void receive_loop( const uint16_t receive_port )
+// Send time of the latest connect of every user, by user id modulo the table size, or 0 once the
+// first packet for it has come back.
+static constexpr size_t connect_stamps_size = 1 << 20;
+static std::vector< std::atomic< int64_t > > connect_stamps( connect_stamps_size );
+
+static std::atomic< uint64_t > sent_events( 0 );
+
+static int64_t now_stamp()
+{
+	return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static std::atomic< int64_t >& connect_stamp( const Event::User user )
+{
+	return connect_stamps[ static_cast< uint32_t >( user ) % connect_stamps_size ];
+}
+
+// User a rating packet is addressed to: binary packets start with version 1 and keep the user at
+// offset 4, text ones start with "id: <user>" or "delta id: <user>".
+static bool packet_user( const std::string_view packet, Event::User& user )
 {
+	constexpr uint8_t binary_version = 1;
+	constexpr size_t binary_user_offset = 4;
+	if ( packet.size() >= binary_user_offset + sizeof( user ) && binary_version == static_cast< uint8_t >( packet[ 0 ] ) ) {
+		user = readI32( packet.data() + binary_user_offset );
+		return true;
+	}
+
+	for ( const std::string_view prefix : {"id: ", "delta id: "} ) {
+		if ( packet.substr( 0, prefix.size() ) == prefix ) {
+			const auto* begin = packet.data() + prefix.size();
+			return std::from_chars( begin, packet.data() + packet.size(), user ).ec == std::errc();
+		}
+	}
+	return false;
+}
+
+void receive_loop( const uint16_t receive_port, const size_t batch_size, const bool print, LatencyHistogram& latencies, uint64_t& packets )
+{
+	using namespace std::chrono_literals;
+
 	auto socket_fd = createSocket();
 	bindSocket( socket_fd, receive_port );
+	setReceiveTimeout( socket_fd, 100ms );
 
 	constexpr size_t buffer_length = 4096;
-	std::string buffer( buffer_length, '\0' );
+	DatagramBatch batch( batch_size, buffer_length );
 	while ( !stopped.load() ) {
-		if ( auto readBytes = recv( socket_fd, buffer.data(), buffer.size(), 0 ); readBytes > 0 ) {
-			std::copy( buffer.cbegin(), buffer.cbegin() + readBytes, std::ostream_iterator< char >( std::cout, "" ) );
-			std::cout << "\n";
+		const auto received = batch.receive( socket_fd );
+		const auto now = now_stamp();
+		for ( size_t i = 0; i < received; ++i ) {
+			const auto packet = batch.datagram( i );
+			if ( Event::User user; packet_user( packet, user ) ) {
+				if ( const auto stamp = connect_stamp( user ).exchange( 0, std::memory_order_relaxed ); stamp != 0 ) {
+					latencies.record( std::chrono::nanoseconds( now - stamp ) );
+				}
+			}
+			if ( print ) {
+				std::cout << packet << "\n";
+			}
 		}
+		packets += received;
 	}
 
 	close( socket_fd );
 }
 
-void send_loop( const char* send_address, const uint16_t send_port, const char* filename, const bool eventAutoGenerated )
+// Open-loop pacing: the i-th event of a sender is due at begin + i * interval whatever the service
+// does, and connect latencies are measured from that time, so a stalled sender does not hide delays.
+class Pacer
 {
-	using namespace std::chrono_literals;
+public:
+	Pacer( const std::chrono::steady_clock::time_point begin, const std::chrono::nanoseconds interval )
+	    : _begin( begin ), _interval( interval )
+	{
+	}
+
+	// Waits for the next event to be due and returns its due time.
+	int64_t next()
+	{
+		using namespace std::chrono_literals;
+		static constexpr auto spin_time = 50us;
+
+		if ( 0 == _interval.count() ) {
+			return now_stamp();
+		}
+
+		const auto due = _begin + _interval * _count++;
+		if ( const auto wait = due - std::chrono::steady_clock::now(); wait > spin_time ) {
+			std::this_thread::sleep_until( due - spin_time );
+		}
+		while ( std::chrono::steady_clock::now() < due ) {
+		}
+		return std::chrono::duration_cast< std::chrono::nanoseconds >( due.time_since_epoch() ).count();
+	}
+
+private:
+	const std::chrono::steady_clock::time_point _begin;
+	const std::chrono::nanoseconds _interval;
+	uint64_t _count = 0;
+};
+
+// Reads the whole input file once and splits it into lines that all senders share.
+static std::vector< std::string_view > read_lines( const char* filename, std::string& contents )
+{
+	std::ifstream in_file( filename, std::ios::binary );
+	contents.assign( std::istreambuf_iterator< char >( in_file ), std::istreambuf_iterator< char >() );
 
+	std::vector< std::string_view > lines;
+	for ( size_t begin = 0; begin < contents.size(); ) {
+		const auto end = std::min( contents.find( '\n', begin ), contents.size() );
+		lines.emplace_back( contents.data() + begin, end - begin );
+		begin = end + 1;
+	}
+	return lines;
+}
+
+void send_loop( const char* send_address,
+                const uint16_t send_port,
+                const std::vector< std::string_view >& lines,
+                const bool eventAutoGenerated,
+                const bool binary,
+                const size_t batch_size,
+                const size_t sender,
+                const size_t senders,
+                Pacer pacer )
+{
 	const auto socket_fd = createSocket();
 	const auto sockaddr = getRemoteSockaddr( send_address, send_port );
 
-	auto send = [&socket_fd, &sockaddr]( const std::string_view str ) {
-		std::this_thread::sleep_for( 1us );
-		sendto( socket_fd, str.data(), str.size(), 0, reinterpret_cast< const struct sockaddr* >( &sockaddr ), sizeof( sockaddr ) );
+	constexpr size_t buffer_length = 1024;
+	DatagramBatch batch( batch_size, buffer_length );
+	size_t pending = 0;
+	auto flush = [&socket_fd, &sockaddr, &batch, &pending] {
+		batch.send( socket_fd, sockaddr, pending );
+		sent_events.fetch_add( pending, std::memory_order_relaxed );
+		pending = 0;
 	};
 
-	if ( !eventAutoGenerated ) {
-		std::ifstream in_file( filename, std::ios::binary );
-		while ( !in_file.eof() && !stopped.load() ) {
-			std::string str;
-			std::getline( in_file, str );
+	auto send = [&batch, &pending, &flush, &pacer]( const Event& event, const std::string_view str ) {
+		const auto due = pacer.next();
+		if ( Event::Type::user_connected == event.type() ) {
+			connect_stamp( event.user() ).store( due, std::memory_order_relaxed );
+		}
+
+		const auto size = std::min( str.size(), batch.bufferSize() );
+		std::copy_n( str.data(), size, batch.buffer( pending ) );
+		batch.setDatagramSize( pending, size );
+		if ( ++pending == batch.capacity() ) {
+			flush();
+		}
+	};
+
+	std::array< char, Event::max_binary_size > binary_buffer;
+	auto send_binary = [&send, &binary_buffer]( const Event& event ) {
+		if ( const auto size = event.toBinary( binary_buffer.data(), binary_buffer.size() ); size > 0 ) {
+			send( event, std::string_view( binary_buffer.data(), size ) );
+		}
+	};
 
-			send( str );
+	if ( !eventAutoGenerated ) {
+		// Senders take every senders-th line, starting from their own index, so that together they
+		// keep the order of the file. Malformed lines are skipped whatever the protocol.
+		for ( size_t line = sender; line < lines.size() && !stopped.load(); line += senders ) {
+			const auto event = Event::fromText( lines[ line ] );
+			if ( !event ) {
+				continue;
+			}
+			if ( !binary ) {
+				send( event, lines[ line ] );
+			}
+			else {
+				send_binary( event );
+			}
 		}
 	}
 	else {
 		std::chrono::nanoseconds currentTime = std::chrono::nanoseconds::zero();
 		EventGenerator eventGenerator;
 		while ( !stopped.load() ) {
-			auto event = eventGenerator.generateEvent( currentTime );
-			if ( Event::Type::user_deal_won == event->type() ) {
-				UserDealWonEvent& dealWonEvent = static_cast< UserDealWonEvent& >( *event );
-				currentTime = dealWonEvent.time();
+			const auto event = eventGenerator.generateEvent( currentTime );
+			if ( const auto* dealWonEvent = event.get< UserDealWonEvent >(); dealWonEvent ) {
+				currentTime = dealWonEvent->time();
+			}
+
+			if ( binary ) {
+				send_binary( event );
+				continue;
 			}
 
 			std::ostringstream ss;
-			ss << *event << "\n";
+			ss << event << "\n";
 
-			send( ss.str() );
+			send( event, ss.str() );
 		}
 	}
 
+	if ( pending > 0 ) {
+		flush();
+	}
 	close( socket_fd );
 }
 
 int main( int argc, char* argv[] )
 {
-	if ( argc < 3 ) {
+	using namespace std::chrono_literals;
+
+	const Options options( argc, argv );
+	const auto& arguments = options.positional();
+	if ( arguments.size() < 3 ) {
 		return -1;
 	}
 
-	const uint16_t receive_port = static_cast< uint16_t >( std::stoul( argv[ 1 ] ) );
-	const char* send_address = argv[ 2 ];
-	const uint16_t send_port = static_cast< uint16_t >( std::stoul( argv[ 3 ] ) );
-	const char* filename = ( argc < 4 ) ? nullptr : argv[ 4 ];
-	const bool eventAutoGenerated = ( argc < 4 );
+	const uint16_t receive_port = static_cast< uint16_t >( std::stoul( std::string( arguments[ 0 ] ) ) );
+	const char* send_address = arguments[ 1 ].data();
+	const uint16_t send_port = static_cast< uint16_t >( std::stoul( std::string( arguments[ 2 ] ) ) );
+	const char* filename = ( arguments.size() < 4 ) ? nullptr : arguments[ 3 ].data();
+	const bool eventAutoGenerated = ( nullptr == filename );
+	const bool binary = "binary" == options.value( "protocol", "text" );
+	const size_t batch_size = std::max< size_t >( 1, options.number( "batch", 1 ) );
+	// Events per second of all senders together; 0 sends as fast as possible.
+	const auto rate = options.number( "rate", 0 );
+	const size_t senders = std::max< size_t >( 1, options.number( "senders", 1 ) );
+	const std::chrono::seconds duration( options.number( "duration", 0 ) );
+	const std::chrono::milliseconds drain_time( options.number( "drain-ms", 1000 ) );
+	const bool print = !options.has( "quiet" );
 
 	signal( SIGINT, []( int ) { stopped.store( true ); } );
 
-	std::thread receive_thread( std::bind( receive_loop, receive_port ) );
+	LatencyHistogram latencies;
+	uint64_t packets = 0;
+	std::thread receive_thread( [&] { receive_loop( receive_port, batch_size, print, latencies, packets ); } );
+
+	const auto begin = std::chrono::steady_clock::now();
+	const std::chrono::nanoseconds interval( rate > 0 ? 1000000000 * senders / rate : 0 );
+	std::string contents;
+	const auto lines = eventAutoGenerated ? std::vector< std::string_view >() : read_lines( filename, contents );
 
-	std::thread send_thread( std::bind( send_loop, send_address, send_port, filename, eventAutoGenerated ) );
+	std::vector< std::thread > send_threads;
+	for ( size_t i = 0; i < senders; ++i ) {
+		// Senders are staggered by a fraction of the interval, so that together they send evenly.
+		const Pacer pacer( begin + interval * i / senders, interval );
+		send_threads.emplace_back( std::bind( send_loop, send_address, send_port, std::cref( lines ), eventAutoGenerated, binary, batch_size, i, senders, pacer ) );
+	}
 
-	send_thread.join();
+	if ( duration.count() > 0 ) {
+		while ( !stopped.load() && std::chrono::steady_clock::now() - begin < duration ) {
+			std::this_thread::sleep_for( 10ms );
+		}
+		stopped.store( true );
+	}
+
+	for ( auto& thread : send_threads ) {
+		thread.join();
+	}
+	const std::chrono::duration< double > send_time = std::chrono::steady_clock::now() - begin;
+
+	// Waits for the packets answering the last connects before stopping the receiver.
+	for ( const auto drain_end = std::chrono::steady_clock::now() + drain_time; !stopped.load() && std::chrono::steady_clock::now() < drain_end; ) {
+		std::this_thread::sleep_for( 10ms );
+	}
+	stopped.store( true );
 	receive_thread.join();
 
+	using microseconds = std::chrono::duration< double, std::micro >;
+	const auto events = sent_events.load();
+	std::cerr << "sent " << events << " events in " << send_time.count() << " s, " << static_cast< double >( events ) / send_time.count()
+	          << " events/s";
+	if ( rate > 0 ) {
+		std::cerr << " of " << rate << " targeted";
+	}
+	std::cerr << ", received " << packets << " packets\n";
+	std::cerr << "connect latency over " << latencies.count() << " connects: p50 " << microseconds( latencies.percentile( 0.5 ) ).count()
+	          << " us, p99 " << microseconds( latencies.percentile( 0.99 ) ).count() << " us, p999 "
+	          << microseconds( latencies.percentile( 0.999 ) ).count() << " us, max " << microseconds( latencies.max() ).count() << " us\n";
+
 	return 0;
 }
@@ -20,12 +20,11 @@ int main( int argc, char* argv[] )
 	std::chrono::nanoseconds currentTime = std::chrono::nanoseconds::zero();
 	EventGenerator eventGenerator;
 	while ( currentTime < duration ) {
-		auto event = eventGenerator.generateEvent( currentTime );
-		if ( Event::Type::user_deal_won == event->type() ) {
-			UserDealWonEvent& dealWonEvent = static_cast< UserDealWonEvent& >( *event );
-			currentTime = dealWonEvent.time();
+		const auto event = eventGenerator.generateEvent( currentTime );
+		if ( const auto* dealWonEvent = event.get< UserDealWonEvent >(); dealWonEvent ) {
+			currentTime = dealWonEvent->time();
 		}
-		file << *event << "\n";
+		file << event << "\n";
 	}
 	file.close();
 	auto end = std::chrono::steady_clock::now();
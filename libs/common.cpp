@@ -1,5 +1,9 @@
 #include "common.h"
 
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
 int createSocket()
 {
 	return socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
@@ -30,3 +34,22 @@ void bindSocket(const int socket, const uint16_t port )
 
 	bind( socket, reinterpret_cast< const struct sockaddr* >( &self ), sizeof( self ) );
 }
+
+void setReusePort( const int socket )
+{
+	const int enable = 1;
+	setsockopt( socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof( enable ) );
+}
+
+void setReceiveTimeout( const int socket, const std::chrono::microseconds timeout )
+{
+	struct timeval value{};
+	value.tv_sec = static_cast< time_t >( timeout.count() / 1000000 );
+	value.tv_usec = static_cast< suseconds_t >( timeout.count() % 1000000 );
+	setsockopt( socket, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof( value ) );
+}
+
+void setNonBlocking( const int socket )
+{
+	fcntl( socket, F_SETFL, fcntl( socket, F_GETFL, 0 ) | O_NONBLOCK );
+}
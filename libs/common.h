@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <string_view>
 
@@ -12,3 +13,10 @@ struct sockaddr_in getSelfSockaddr( const uint16_t port );
 struct sockaddr_in getRemoteSockaddr( const std::string_view address, const uint16_t port );
 
 void bindSocket( const int socket, const uint16_t port );
+
+// Lets several sockets bind the same port; the kernel spreads incoming datagrams between them.
+void setReusePort( const int socket );
+
+void setReceiveTimeout( const int socket, const std::chrono::microseconds timeout );
+
+void setNonBlocking( const int socket );
@@ -0,0 +1,92 @@
+#include "datagram_batch.h"
+
+DatagramBatch::DatagramBatch( const size_t capacity, const size_t datagram_size )
+    : _datagram_size( datagram_size ), _buffers( capacity * datagram_size ), _iovecs( capacity ), _messages( capacity )
+{
+	for ( size_t i = 0; i < capacity; ++i ) {
+		_iovecs[ i ].iov_base = buffer( i );
+		_iovecs[ i ].iov_len = _datagram_size;
+		_messages[ i ].msg_hdr.msg_iov = &_iovecs[ i ];
+		_messages[ i ].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+size_t DatagramBatch::capacity() const noexcept
+{
+	return _messages.size();
+}
+
+size_t DatagramBatch::receive( const int socket, const bool wait )
+{
+	for ( size_t i = 0; i < capacity(); ++i ) {
+		_iovecs[ i ].iov_len = _datagram_size;
+		_messages[ i ].msg_hdr.msg_name = nullptr;
+		_messages[ i ].msg_hdr.msg_namelen = 0;
+	}
+
+	const auto received = recvmmsg( socket, _messages.data(), static_cast< unsigned int >( capacity() ), wait ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr );
+	if ( received <= 0 ) {
+		return 0;
+	}
+
+	++_calls;
+	_datagrams += static_cast< uint64_t >( received );
+	return static_cast< size_t >( received );
+}
+
+std::string_view DatagramBatch::datagram( const size_t index ) const noexcept
+{
+	return {_buffers.data() + index * _datagram_size, _messages[ index ].msg_len};
+}
+
+char* DatagramBatch::buffer( const size_t index ) noexcept
+{
+	return _buffers.data() + index * _datagram_size;
+}
+
+size_t DatagramBatch::bufferSize() const noexcept
+{
+	return _datagram_size;
+}
+
+void DatagramBatch::setDatagramSize( const size_t index, const size_t size ) noexcept
+{
+	_iovecs[ index ].iov_len = size;
+	_messages[ index ].msg_len = static_cast< unsigned int >( size );
+}
+
+size_t DatagramBatch::send( const int socket, const struct sockaddr_in& address, const size_t count )
+{
+	for ( size_t i = 0; i < count; ++i ) {
+		_messages[ i ].msg_hdr.msg_name = const_cast< struct sockaddr_in* >( &address );
+		_messages[ i ].msg_hdr.msg_namelen = sizeof( address );
+	}
+
+	size_t sent = 0;
+	while ( sent < count ) {
+		const auto result = sendmmsg( socket, _messages.data() + sent, static_cast< unsigned int >( count - sent ), 0 );
+		if ( result <= 0 ) {
+			break;
+		}
+		++_calls;
+		sent += static_cast< size_t >( result );
+	}
+
+	_datagrams += sent;
+	return sent;
+}
+
+uint64_t DatagramBatch::calls() const noexcept
+{
+	return _calls;
+}
+
+uint64_t DatagramBatch::datagrams() const noexcept
+{
+	return _datagrams;
+}
+
+double DatagramBatch::averageFill() const noexcept
+{
+	return 0 == _calls ? 0.0 : static_cast< double >( _datagrams ) / static_cast< double >( _calls );
+}
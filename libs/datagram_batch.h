@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Preallocated ring of datagram buffers moved with one recvmmsg/sendmmsg call per batch.
+class DatagramBatch
+{
+public:
+	DatagramBatch( const size_t capacity, const size_t datagram_size );
+
+	size_t capacity() const noexcept;
+
+	// Waits for at least one datagram unless wait is false.
+	size_t receive( const int socket, const bool wait = true );
+	// Last received datagram, or the one prepared for sending by setDatagramSize().
+	std::string_view datagram( const size_t index ) const noexcept;
+
+	char* buffer( const size_t index ) noexcept;
+	size_t bufferSize() const noexcept;
+	void setDatagramSize( const size_t index, const size_t size ) noexcept;
+	size_t send( const int socket, const struct sockaddr_in& address, const size_t count );
+
+	uint64_t calls() const noexcept;
+	uint64_t datagrams() const noexcept;
+	double averageFill() const noexcept;
+
+private:
+	const size_t _datagram_size;
+	std::vector< char > _buffers;
+	std::vector< struct iovec > _iovecs;
+	std::vector< struct mmsghdr > _messages;
+
+	uint64_t _calls = 0;
+	uint64_t _datagrams = 0;
+};
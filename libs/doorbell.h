@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Wake-up point for a consumer of one or more lock-free queues. The consumer spins for an
+// adaptive number of iterations before parking on a futex; producers only issue a wake-up
+// syscall when the consumer is actually parked.
+class Doorbell
+{
+public:
+	// Returns false once the doorbell is closed.
+	template < typename Ready >
+	bool wait( Ready&& ready )
+	{
+		for ( uint32_t i = 0; i < _spin_limit; ++i ) {
+			if ( closed() ) {
+				return false;
+			}
+			if ( ready() ) {
+				_spin_limit = std::min( _spin_limit * 2, max_spin );
+				return true;
+			}
+		}
+		_spin_limit = std::max( _spin_limit / 2, min_spin );
+
+		while ( !closed() && !ready() ) {
+			_sleeping.store( 1, std::memory_order_seq_cst );
+			if ( !ready() && !_closed.load( std::memory_order_seq_cst ) ) {
+				syscall( SYS_futex, &_sleeping, FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0 );
+			}
+			_sleeping.store( 0, std::memory_order_relaxed );
+		}
+		return !closed();
+	}
+
+	void ring()
+	{
+		if ( _sleeping.load( std::memory_order_seq_cst ) && _sleeping.exchange( 0, std::memory_order_seq_cst ) ) {
+			syscall( SYS_futex, &_sleeping, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+		}
+	}
+
+	void close()
+	{
+		_closed.store( true, std::memory_order_seq_cst );
+		ring();
+	}
+
+	bool closed() const noexcept
+	{
+		return _closed.load( std::memory_order_relaxed );
+	}
+
+private:
+	static constexpr uint32_t min_spin = 16;
+	static constexpr uint32_t max_spin = 16 * 1024;
+
+	alignas( 64 ) std::atomic< uint32_t > _sleeping{0};
+	std::atomic< bool > _closed{false};
+	uint32_t _spin_limit = min_spin;
+};
@@ -1,190 +1,149 @@
 #include "event.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <optional>
 
-std::ostream& operator<<( std::ostream& out_stream, const Event::Type& type )
-{
-	out_stream << static_cast< std::underlying_type_t< Event::Type > >( type );
-	return out_stream;
-}
+#include "little_endian.h"
 
-std::istream& operator>>( std::istream& in_stream, Event::Type& type )
+namespace
 {
-	type = Event::Type::undefined;
-
-	std::underlying_type_t< Event::Type > tmp_type;
-	in_stream >> tmp_type;
+	size_t nameToBinary( char* buffer, const size_t size, const std::string_view name )
+	{
+		const auto length = Event::binary_header_size + 1 + name.size();
+		if ( name.size() > UINT8_MAX || size < length ) {
+			return 0;
+		}
+		writeU8( buffer + Event::binary_header_size, static_cast< uint8_t >( name.size() ) );
+		std::memcpy( buffer + Event::binary_header_size + 1, name.data(), name.size() );
+		return length;
+	}
 
-	switch ( static_cast< Event::Type >( tmp_type ) ) {
-		case Event::Type::user_registered:
-		case Event::Type::user_renamed:
-		case Event::Type::user_deal_won:
-		case Event::Type::user_connected:
-		case Event::Type::user_disconnected:
-		case Event::Type::undefined:
-			type = static_cast< Event::Type >( tmp_type );
+	std::optional< std::string_view > nameFromBinary( const std::string_view data )
+	{
+		if ( data.size() < Event::binary_header_size + 1 ) {
+			return std::nullopt;
+		}
+		const auto length = readU8( data.data() + Event::binary_header_size );
+		if ( data.size() < Event::binary_header_size + 1 + length ) {
+			return std::nullopt;
+		}
+		return data.substr( Event::binary_header_size + 1, length );
 	}
 
-	return in_stream;
-}
+	class TextReader
+	{
+	public:
+		TextReader( const std::string_view data ) : _data( data )
+		{
+		}
 
-Event::Event( const User user, const Type type ) : _user( user ), _type( type )
-{
-}
+		std::optional< std::string_view > token()
+		{
+			const auto begin = _data.find_first_not_of( " \t\r\n" );
+			if ( begin == std::string_view::npos ) {
+				return std::nullopt;
+			}
+			const auto end = std::min( _data.find_first_of( " \t\r\n", begin ), _data.size() );
+			const auto result = _data.substr( begin, end - begin );
+			_data.remove_prefix( end );
+			return result;
+		}
 
-Event::Type Event::type() const noexcept
-{
-	return _type;
-}
+		template < typename T >
+		std::optional< T > number()
+		{
+			const auto text = token();
+			T value;
+			if ( !text || std::from_chars( text->data(), text->data() + text->size(), value ).ec != std::errc() ) {
+				return std::nullopt;
+			}
+			return value;
+		}
 
-void Event::setType( const Type& type ) noexcept
-{
-	_type = type;
-}
+	private:
+		std::string_view _data;
+	};
+}  // namespace
 
-Event::User Event::user() const noexcept
+EventName::EventName( const std::string_view name ) noexcept : _size( static_cast< uint8_t >( std::min( name.size(), capacity ) ) )
 {
-	return _user;
+	std::copy_n( name.data(), _size, _data.begin() );
 }
 
-void Event::setUser( const User& user )
+std::string_view EventName::view() const noexcept
 {
-	_user = user;
+	return {_data.data(), _size};
 }
 
-std::unique_ptr< Event > Event::createEvent( const Event& event )
+EventName::operator std::string_view() const noexcept
 {
-	switch ( event._type ) {
-		case Type::undefined:
-			return nullptr;
-		case Type::user_registered:
-			return std::make_unique< UserRegisteredEvent >( event );
-		case Type::user_renamed:
-			return std::make_unique< UserRenamedEvent >( event );
-		case Type::user_deal_won:
-			return std::make_unique< UserDealWonEvent >( event );
-		case Type::user_connected:
-			return std::make_unique< UserConnectedEvent >( event );
-		case Type::user_disconnected:
-			return std::make_unique< UserDisconnectedEvent >( event );
-	}
-	return nullptr;
-}
-
-BaseEvent::BaseEvent( User user, Type type ) : Event( user, type )
-{
-}
-
-std::ostream& BaseEvent::to_stream( std::ostream& out_stream ) const
-{
-	return out_stream;
-}
-
-std::istream& BaseEvent::finish_reading( std::istream& in_stream )
-{
-	return in_stream;
-}
-
-std::ostream& operator<<( std::ostream& out_stream, const Event& event )
-{
-	out_stream << event._type << " " << event._user;
-	return event.to_stream( out_stream );
+	return view();
 }
 
-std::istream& operator>>( std::istream& in_stream, Event& event )
+BaseEvent::BaseEvent( const User user ) noexcept : _user( user )
 {
-	if ( Event::Type::undefined == event._type ) {
-		return in_stream >> event._type >> event._user;
-	}
-	else {
-		return event.finish_reading( in_stream );
-	}
 }
 
-UserRegisteredEvent::UserRegisteredEvent( const Event& event ) : Event( event )
+BaseEvent::User BaseEvent::user() const noexcept
 {
+	return _user;
 }
 
-UserRegisteredEvent::UserRegisteredEvent( const User user, const std::string_view name )
-    : Event( user, Type::user_registered ), _name( name )
+void BaseEvent::setUser( const User& user ) noexcept
 {
+	_user = user;
 }
 
-std::ostream& UserRegisteredEvent::to_stream( std::ostream& out_stream ) const
+std::ostream& operator<<( std::ostream& out_stream, const BaseEvent::Type& type )
 {
-	out_stream << " " << _name;
+	out_stream << static_cast< std::underlying_type_t< BaseEvent::Type > >( type );
 	return out_stream;
 }
 
-std::istream& UserRegisteredEvent::finish_reading( std::istream& in_stream )
+UserRegisteredEvent::UserRegisteredEvent( const User user, const std::string_view name ) noexcept : BaseEvent( user ), _name( name )
 {
-	in_stream.get();
-	in_stream >> _name;
-	return in_stream;
 }
 
-std::string UserRegisteredEvent::name() const
+std::string_view UserRegisteredEvent::name() const noexcept
 {
 	return _name;
 }
 
-void UserRegisteredEvent::setName( const std::string_view name )
+void UserRegisteredEvent::setName( const std::string_view name ) noexcept
 {
 	_name = name;
 }
 
-UserRenamedEvent::UserRenamedEvent( const Event& event ) : Event( event )
+UserRenamedEvent::UserRenamedEvent( const User user, const std::string_view name ) noexcept : BaseEvent( user ), _name( name )
 {
 }
 
-UserRenamedEvent::UserRenamedEvent( const User user, const std::string_view name ) : Event( user, Type::user_renamed ), _name( name )
-{
-}
-
-std::ostream& UserRenamedEvent::to_stream( std::ostream& out_stream ) const
-{
-	out_stream << " " << _name;
-	return out_stream;
-}
-
-std::istream& UserRenamedEvent::finish_reading( std::istream& in_stream )
-{
-	in_stream.get();
-	in_stream >> _name;
-	return in_stream;
-}
-
-std::string UserRenamedEvent::name() const
+std::string_view UserRenamedEvent::name() const noexcept
 {
 	return _name;
 }
 
-void UserRenamedEvent::setName( const std::string_view name )
+void UserRenamedEvent::setName( const std::string_view name ) noexcept
 {
 	_name = name;
 }
 
-UserDealWonEvent::UserDealWonEvent( const Event& event ) : Event( event )
+UserDealWonEvent::UserDealWonEvent( const User user, const std::chrono::nanoseconds time, const int64_t amount ) noexcept
+    : BaseEvent( user ), _time( time ), _amount( amount )
 {
 }
 
-UserDealWonEvent::UserDealWonEvent( const User user, const std::chrono::nanoseconds time, const int64_t amount )
-    : Event( user, Type::user_deal_won ), _time( time ), _amount( amount )
-{
-}
-
-std::ostream& UserDealWonEvent::to_stream( std::ostream& out_stream ) const
+std::chrono::nanoseconds UserDealWonEvent::time() const noexcept
 {
-	out_stream << " " << _time.count() << " " << _amount;
-	return out_stream;
+	return _time;
 }
 
-std::istream& UserDealWonEvent::finish_reading( std::istream& in_stream )
+void UserDealWonEvent::setTime( const std::chrono::nanoseconds& time ) noexcept
 {
-	decltype( _time.count() ) tmp;
-	in_stream >> tmp >> _amount;
-	_time = decltype( _time )( tmp );
-	return in_stream;
+	_time = time;
 }
 
 int64_t UserDealWonEvent::amount() const noexcept
@@ -192,53 +151,171 @@ int64_t UserDealWonEvent::amount() const noexcept
 	return _amount;
 }
 
-void UserDealWonEvent::setAmount( const int64_t& amount )
+void UserDealWonEvent::setAmount( const int64_t& amount ) noexcept
 {
 	_amount = amount;
 }
 
-std::chrono::nanoseconds UserDealWonEvent::time() const noexcept
+UserConnectedEvent::UserConnectedEvent( const User user ) noexcept : BaseEvent( user )
 {
-	return _time;
 }
 
-void UserDealWonEvent::setTime( const std::chrono::nanoseconds& time )
+UserDisconnectedEvent::UserDisconnectedEvent( const User user ) noexcept : BaseEvent( user )
 {
-	_time = time;
 }
 
-UserConnectedEvent::UserConnectedEvent( const Event& event ) : Event( event )
+Event::Type Event::type() const noexcept
 {
+	return static_cast< Type >( static_cast< std::underlying_type_t< Type > >( _event.index() ) - 1 );
 }
 
-UserConnectedEvent::UserConnectedEvent( const User user ) : Event( user, Type::user_connected )
+Event::User Event::user() const noexcept
 {
+	return std::visit(
+	    []( const auto& event ) -> User {
+		    if constexpr ( std::is_base_of_v< BaseEvent, std::decay_t< decltype( event ) > > ) {
+			    return event.user();
+		    }
+		    else {
+			    return -1;
+		    }
+	    },
+	    _event );
 }
 
-std::ostream& UserConnectedEvent::to_stream( std::ostream& out_stream ) const
+Event::operator bool() const noexcept
 {
-	return out_stream;
+	return Type::undefined != type();
 }
 
-std::istream& UserConnectedEvent::finish_reading( std::istream& in_stream )
+Event Event::fromText( const std::string_view data ) noexcept
 {
-	return in_stream;
-}
+	TextReader reader( data );
+	const auto type = reader.number< std::underlying_type_t< Type > >();
+	const auto user = reader.number< User >();
+	if ( !type || !user ) {
+		return {};
+	}
 
-UserDisconnectedEvent::UserDisconnectedEvent( const Event& event ) : Event( event )
-{
+	switch ( static_cast< Type >( *type ) ) {
+		case Type::undefined:
+			return {};
+		case Type::user_registered:
+			if ( const auto name = reader.token(); name ) {
+				return UserRegisteredEvent( *user, *name );
+			}
+			return {};
+		case Type::user_renamed:
+			if ( const auto name = reader.token(); name ) {
+				return UserRenamedEvent( *user, *name );
+			}
+			return {};
+		case Type::user_deal_won: {
+			const auto time = reader.number< std::chrono::nanoseconds::rep >();
+			const auto amount = reader.number< int64_t >();
+			if ( time && amount ) {
+				return UserDealWonEvent( *user, std::chrono::nanoseconds( *time ), *amount );
+			}
+			return {};
+		}
+		case Type::user_connected:
+			return UserConnectedEvent( *user );
+		case Type::user_disconnected:
+			return UserDisconnectedEvent( *user );
+	}
+	return {};
 }
 
-UserDisconnectedEvent::UserDisconnectedEvent( const User user ) : Event( user, Type::user_disconnected )
+Event Event::fromBinary( const std::string_view data ) noexcept
 {
+	if ( data.size() < binary_header_size || binary_version != readU8( data.data() ) ) {
+		return {};
+	}
+
+	const auto type = static_cast< Type >( readU8( data.data() + 1 ) );
+	const auto user = readI32( data.data() + binary_user_offset );
+	switch ( type ) {
+		case Type::undefined:
+			return {};
+		case Type::user_registered:
+			if ( const auto name = nameFromBinary( data ); name ) {
+				return UserRegisteredEvent( user, *name );
+			}
+			return {};
+		case Type::user_renamed:
+			if ( const auto name = nameFromBinary( data ); name ) {
+				return UserRenamedEvent( user, *name );
+			}
+			return {};
+		case Type::user_deal_won:
+			if ( data.size() < binary_header_size + 2 * sizeof( int64_t ) ) {
+				return {};
+			}
+			return UserDealWonEvent( user,
+			                         std::chrono::nanoseconds( readI64( data.data() + binary_header_size ) ),
+			                         readI64( data.data() + binary_header_size + sizeof( int64_t ) ) );
+		case Type::user_connected:
+			return UserConnectedEvent( user );
+		case Type::user_disconnected:
+			return UserDisconnectedEvent( user );
+	}
+	return {};
 }
 
-std::ostream& UserDisconnectedEvent::to_stream( std::ostream& out_stream ) const
+size_t Event::toBinary( char* buffer, const size_t size ) const noexcept
 {
-	return out_stream;
+	if ( size < binary_header_size || !*this ) {
+		return 0;
+	}
+
+	writeU8( buffer, binary_version );
+	writeU8( buffer + 1, static_cast< uint8_t >( type() ) );
+	std::memset( buffer + 2, 0, 2 );
+	writeI32( buffer + binary_user_offset, user() );
+
+	switch ( type() ) {
+		case Type::undefined:
+			return 0;
+		case Type::user_registered:
+			return nameToBinary( buffer, size, get< UserRegisteredEvent >()->name() );
+		case Type::user_renamed:
+			return nameToBinary( buffer, size, get< UserRenamedEvent >()->name() );
+		case Type::user_deal_won: {
+			const auto length = binary_header_size + 2 * sizeof( int64_t );
+			if ( size < length ) {
+				return 0;
+			}
+			const auto& deal = *get< UserDealWonEvent >();
+			writeI64( buffer + binary_header_size, deal.time().count() );
+			writeI64( buffer + binary_header_size + sizeof( int64_t ), deal.amount() );
+			return length;
+		}
+		case Type::user_connected:
+		case Type::user_disconnected:
+			return binary_header_size;
+	}
+	return 0;
 }
 
-std::istream& UserDisconnectedEvent::finish_reading( std::istream& in_stream )
+std::ostream& operator<<( std::ostream& out_stream, const Event& event )
 {
-	return in_stream;
+	out_stream << event.type() << " " << event.user();
+	switch ( event.type() ) {
+		case Event::Type::user_registered:
+			out_stream << " " << event.get< UserRegisteredEvent >()->name();
+			break;
+		case Event::Type::user_renamed:
+			out_stream << " " << event.get< UserRenamedEvent >()->name();
+			break;
+		case Event::Type::user_deal_won: {
+			const auto& deal = *event.get< UserDealWonEvent >();
+			out_stream << " " << deal.time().count() << " " << deal.amount();
+			break;
+		}
+		case Event::Type::undefined:
+		case Event::Type::user_connected:
+		case Event::Type::user_disconnected:
+			break;
+	}
+	return out_stream;
 }
@@ -1,14 +1,33 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <iosfwd>
-#include <memory>
-#include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
+#include <variant>
 
-class Event
+// Name stored inline in the event, truncated to capacity bytes.
+class EventName
+{
+public:
+	static constexpr size_t capacity = 48;
+
+	EventName() = default;
+	EventName( const std::string_view name ) noexcept;
+
+	std::string_view view() const noexcept;
+	operator std::string_view() const noexcept;
+
+private:
+	uint8_t _size = 0;
+	std::array< char, capacity > _data;
+};
+
+class BaseEvent
 {
 public:
 	using User = int32_t;
@@ -22,118 +41,136 @@ public:
 		user_connected,
 		user_disconnected,
 	};
-	friend std::ostream& operator<<( std::ostream& out_stream, const Type& type );
-	friend std::istream& operator>>( std::istream& in_stream, const Type& type );
-
-	Event( const User user, const Type type );
-	Event() = default;
-	Event( const Event& ) = default;
-	Event& operator=( const Event& ) = default;
-	Event( Event&& ) = default;
-	Event& operator=( Event&& ) = default;
-	virtual ~Event() = default;
 
-	Type type() const noexcept;
-	void setType( const Type& type ) noexcept;
+	BaseEvent() = default;
+	BaseEvent( const User user ) noexcept;
 
 	User user() const noexcept;
-	void setUser( const User& user );
-
-	static std::unique_ptr< Event > createEvent( const Event& event );
-
-	friend std::ostream& operator<<( std::ostream& out_stream, const Event& event );
-	friend std::istream& operator>>( std::istream& in_stream, Event& event );
+	void setUser( const User& user ) noexcept;
 
 protected:
 	User _user = -1;
-	Type _type = Type::undefined;
-
-private:
-	virtual std::ostream& to_stream( std::ostream& out_stream ) const = 0;
-	virtual std::istream& finish_reading( std::istream& in_stream ) = 0;
 };
 
-class BaseEvent : public Event
-{
-public:
-	BaseEvent() = default;
-	BaseEvent( User user, Type type );
-
-private:
-	std::ostream& to_stream( std::ostream& out_stream ) const override;
-	std::istream& finish_reading( std::istream& in_stream ) override;
-};
+std::ostream& operator<<( std::ostream& out_stream, const BaseEvent::Type& type );
 
-class UserRegisteredEvent : public Event
+class UserRegisteredEvent : public BaseEvent
 {
 public:
-	UserRegisteredEvent( const Event& event );
-	UserRegisteredEvent( const User user, const std::string_view name );
+	static constexpr Type event_type = Type::user_registered;
 
-	std::string name() const;
-	void setName(const std::string_view name );
+	UserRegisteredEvent() = default;
+	UserRegisteredEvent( const User user, const std::string_view name ) noexcept;
 
-private:
-	std::ostream& to_stream( std::ostream& out_stream ) const override;
-	std::istream& finish_reading( std::istream& in_stream ) override;
+	std::string_view name() const noexcept;
+	void setName( const std::string_view name ) noexcept;
 
-	std::string _name;
+private:
+	EventName _name;
 };
 
-class UserRenamedEvent : public Event
+class UserRenamedEvent : public BaseEvent
 {
 public:
-	UserRenamedEvent( const Event& event );
-	UserRenamedEvent( const User user, const std::string_view name );
+	static constexpr Type event_type = Type::user_renamed;
 
-	std::string name() const;
-	void setName(const std::string_view name );
+	UserRenamedEvent() = default;
+	UserRenamedEvent( const User user, const std::string_view name ) noexcept;
 
-private:
-	std::ostream& to_stream( std::ostream& out_stream ) const override;
-	std::istream& finish_reading( std::istream& in_stream ) override;
+	std::string_view name() const noexcept;
+	void setName( const std::string_view name ) noexcept;
 
-	std::string _name;
+private:
+	EventName _name;
 };
 
-class UserDealWonEvent : public Event
+class UserDealWonEvent : public BaseEvent
 {
 public:
-	UserDealWonEvent( const Event& event );
-	UserDealWonEvent( const User user, const std::chrono::nanoseconds time, const int64_t amount );
+	static constexpr Type event_type = Type::user_deal_won;
+
+	UserDealWonEvent() = default;
+	UserDealWonEvent( const User user, const std::chrono::nanoseconds time, const int64_t amount ) noexcept;
 
 	std::chrono::nanoseconds time() const noexcept;
-	void setTime( const std::chrono::nanoseconds& time );
+	void setTime( const std::chrono::nanoseconds& time ) noexcept;
 
 	int64_t amount() const noexcept;
-	void setAmount( const int64_t& amount );
+	void setAmount( const int64_t& amount ) noexcept;
 
 private:
-	std::ostream& to_stream( std::ostream& out_stream ) const override;
-	std::istream& finish_reading( std::istream& in_stream ) override;
-
-	std::chrono::nanoseconds _time;
+	std::chrono::nanoseconds _time{};
 	int64_t _amount = {};
 };
 
-class UserConnectedEvent : public Event
+class UserConnectedEvent : public BaseEvent
 {
 public:
-	UserConnectedEvent( const Event& event );
-	UserConnectedEvent( const User user );
+	static constexpr Type event_type = Type::user_connected;
 
-private:
-	std::ostream& to_stream( std::ostream& out_stream ) const override;
-	std::istream& finish_reading( std::istream& in_stream ) override;
+	UserConnectedEvent() = default;
+	UserConnectedEvent( const User user ) noexcept;
+};
+
+class UserDisconnectedEvent : public BaseEvent
+{
+public:
+	static constexpr Type event_type = Type::user_disconnected;
+
+	UserDisconnectedEvent() = default;
+	UserDisconnectedEvent( const User user ) noexcept;
 };
 
-class UserDisconnectedEvent : public Event
+// Trivially copyable tagged value: passes through queues by value, dispatched with visit().
+// Alternatives follow the order of Type, with std::monostate standing for Type::undefined.
+class Event
 {
 public:
-	UserDisconnectedEvent( const Event& event );
-	UserDisconnectedEvent( const User user );
+	using User = BaseEvent::User;
+	using Type = BaseEvent::Type;
+	using Variant = std::
+	    variant< std::monostate, UserRegisteredEvent, UserRenamedEvent, UserDealWonEvent, UserConnectedEvent, UserDisconnectedEvent >;
+
+	Event() = default;
+
+	template < typename T, typename = std::enable_if_t< std::is_base_of_v< BaseEvent, T > > >
+	Event( const T& event ) noexcept : _event( event )
+	{
+	}
+
+	Type type() const noexcept;
+	User user() const noexcept;
+
+	explicit operator bool() const noexcept;
+
+	template < typename T >
+	const T* get() const noexcept
+	{
+		return std::get_if< T >( &_event );
+	}
+
+	template < typename Visitor >
+	decltype( auto ) visit( Visitor&& visitor ) const
+	{
+		return std::visit( std::forward< Visitor >( visitor ), _event );
+	}
+
+	static Event fromText( const std::string_view data ) noexcept;
+
+	// Binary layout, little-endian: u8 version, u8 type, u16 reserved, i32 user, then
+	// u8 length + bytes of the name, or i64 time + i64 amount for user_deal_won.
+	static constexpr uint8_t binary_version = 1;
+	static constexpr size_t binary_header_size = 8;
+	static constexpr size_t binary_user_offset = 4;
+	static constexpr size_t max_binary_size = binary_header_size + 1 + UINT8_MAX;
+
+	static Event fromBinary( const std::string_view data ) noexcept;
+	size_t toBinary( char* buffer, const size_t size ) const noexcept;
+
+	friend std::ostream& operator<<( std::ostream& out_stream, const Event& event );
 
 private:
-	std::ostream& to_stream( std::ostream& out_stream ) const override;
-	std::istream& finish_reading( std::istream& in_stream ) override;
+	Variant _event;
 };
+
+static_assert( std::is_trivially_copyable_v< Event > );
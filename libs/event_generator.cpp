@@ -22,41 +22,42 @@ EventGenerator::EventGenerator( const Event::User min_user,
 {
 }
 
-std::unique_ptr< Event > EventGenerator::generateEvent(const std::chrono::nanoseconds time)
+Event EventGenerator::generateEvent(const std::chrono::nanoseconds time)
 {
-	BaseEvent base_event( get_random_user(), get_random_event() );
-	while ( !is_allowed_event( base_event ) ) {
-		base_event.setType( get_random_event() );
+	const auto user = get_random_user();
+	auto type = get_random_event();
+	while ( !is_allowed_event( user, type ) ) {
+		type = get_random_event();
 	}
 
-	std::unique_ptr< Event > event;
-	switch ( base_event.type() ) {
+	Event event;
+	switch ( type ) {
 		case Event::Type::user_registered: {
 			auto name = get_random_name();
-			event.reset( new UserRegisteredEvent( base_event.user(), name ) );
-			_registered_users.emplace( base_event.user(), name );
+			event = UserRegisteredEvent( user, name );
+			_registered_users.emplace( user, name );
 			break;
 		}
 		case Event::Type::user_renamed: {
 			auto name = get_random_name();
-			event.reset( new UserRenamedEvent( base_event.user(), name ) );
-			_registered_users.emplace( base_event.user(), name );
+			event = UserRenamedEvent( user, name );
+			_registered_users.emplace( user, name );
 			break;
 		}
 		case Event::Type::user_deal_won: {
 			auto random_time = get_random_time();
 			auto amount = get_random_amount();
-			event.reset( new UserDealWonEvent( base_event.user(), time + random_time, amount ) );
+			event = UserDealWonEvent( user, time + random_time, amount );
 			break;
 		}
 		case Event::Type::user_connected: {
-			event.reset( new UserConnectedEvent( base_event.user() ) );
-			_connected_users.emplace( base_event.user() );
+			event = UserConnectedEvent( user );
+			_connected_users.emplace( user );
 			break;
 		}
 		case Event::Type::user_disconnected: {
-			event.reset( new UserDisconnectedEvent( base_event.user() ) );
-			_connected_users.erase( base_event.user() );
+			event = UserDisconnectedEvent( user );
+			_connected_users.erase( user );
 			break;
 		}
 		case Event::Type::undefined: {
@@ -97,16 +98,15 @@ int32_t EventGenerator::get_random_amount()
 	return _amount_distribution( _generator );
 }
 
-bool EventGenerator::is_allowed_event( const Event& event )
+bool EventGenerator::is_allowed_event( const Event::User user, const Event::Type type )
 {
-	if ( _registered_users.find( event.user() ) == _registered_users.cend() ) {
-		return Event::Type::user_registered == event.type();
+	if ( _registered_users.find( user ) == _registered_users.cend() ) {
+		return Event::Type::user_registered == type;
 	}
 
-	if ( _connected_users.find( event.user() ) == _connected_users.cend() ) {
-		return Event::Type::user_connected == event.type();
+	if ( _connected_users.find( user ) == _connected_users.cend() ) {
+		return Event::Type::user_connected == type;
 	}
 
-	return Event::Type::user_renamed == event.type() || Event::Type::user_deal_won == event.type()
-	       || Event::Type::user_disconnected == event.type();
+	return Event::Type::user_renamed == type || Event::Type::user_deal_won == type || Event::Type::user_disconnected == type;
 }
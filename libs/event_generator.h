@@ -28,7 +28,7 @@ public:
 	                const int32_t min_amount = _min_amount,
 	                const int32_t max_amount = _max_amount );
 
-	std::unique_ptr< Event > generateEvent(const std::chrono::nanoseconds time);
+	Event generateEvent(const std::chrono::nanoseconds time);
 
 private:
 	Event::User get_random_user();
@@ -41,7 +41,7 @@ private:
 
 	int32_t get_random_amount();
 
-	bool is_allowed_event( const Event& event );
+	bool is_allowed_event( const Event::User user, const Event::Type type );
 
 	std::unordered_map< Event::User, std::string > _registered_users;
 	std::unordered_set< Event::User > _connected_users;
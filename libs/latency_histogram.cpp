@@ -0,0 +1,82 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+void add( std::atomic< uint64_t >& counter, const uint64_t value ) noexcept
+{
+	counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+}
+
+void LatencyHistogram::record( const std::chrono::nanoseconds duration ) noexcept
+{
+	const auto value = static_cast< uint64_t >( std::max< int64_t >( 0, duration.count() ) );
+	add( _buckets[ bucket( value ) ], 1 );
+	add( _count, 1 );
+	if ( value > _max.load( std::memory_order_relaxed ) ) {
+		_max.store( value, std::memory_order_relaxed );
+	}
+}
+
+uint64_t LatencyHistogram::count() const noexcept
+{
+	return _count.load( std::memory_order_relaxed );
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const noexcept
+{
+	return std::chrono::nanoseconds( _max.load( std::memory_order_relaxed ) );
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile( const double fraction ) const noexcept
+{
+	const auto total = count();
+	if ( 0 == total ) {
+		return {};
+	}
+
+	const auto rank = std::max< uint64_t >( 1, static_cast< uint64_t >( std::ceil( fraction * static_cast< double >( total ) ) ) );
+	uint64_t seen = 0;
+	for ( size_t i = 0; i < buckets_count; ++i ) {
+		seen += _buckets[ i ].load( std::memory_order_relaxed );
+		if ( seen >= rank ) {
+			return std::chrono::nanoseconds( std::min( upperBound( i ), _max.load( std::memory_order_relaxed ) ) );
+		}
+	}
+	return max();
+}
+
+void LatencyHistogram::merge( const LatencyHistogram& other ) noexcept
+{
+	for ( size_t i = 0; i < buckets_count; ++i ) {
+		add( _buckets[ i ], other._buckets[ i ].load( std::memory_order_relaxed ) );
+	}
+	add( _count, other.count() );
+	if ( other._max.load( std::memory_order_relaxed ) > _max.load( std::memory_order_relaxed ) ) {
+		_max.store( other._max.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+	}
+}
+
+size_t LatencyHistogram::bucket( const uint64_t value ) noexcept
+{
+	// Values below sub_buckets get a bucket each, larger ones sub_buckets per power of two.
+	if ( value < sub_buckets ) {
+		return static_cast< size_t >( value );
+	}
+	const auto magnitude = static_cast< size_t >( 63 - __builtin_clzll( value ) );
+	const auto shift = magnitude - sub_bucket_bits;
+	return ( shift + 1 ) * sub_buckets + static_cast< size_t >( ( value >> shift ) & ( sub_buckets - 1 ) );
+}
+
+uint64_t LatencyHistogram::upperBound( const size_t bucket ) noexcept
+{
+	if ( bucket < sub_buckets ) {
+		return bucket;
+	}
+	const auto shift = bucket / sub_buckets - 1;
+	const auto sub_bucket = static_cast< uint64_t >( bucket % sub_buckets ) + sub_buckets;
+	return ( ( sub_bucket + 1 ) << shift ) - 1;
+}
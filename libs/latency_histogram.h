@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear histogram of nanosecond durations: every power of two is split into sub_buckets
+// buckets, so a percentile is off by at most 1/sub_buckets of its value. Counters are written by
+// one thread with relaxed stores and may be read by any thread at the same time.
+class LatencyHistogram
+{
+public:
+	static constexpr size_t sub_bucket_bits = 3;
+	static constexpr size_t sub_buckets = size_t( 1 ) << sub_bucket_bits;
+	static constexpr size_t buckets_count = ( 64 - sub_bucket_bits + 1 ) * sub_buckets;
+
+	void record( const std::chrono::nanoseconds duration ) noexcept;
+
+	uint64_t count() const noexcept;
+	std::chrono::nanoseconds max() const noexcept;
+
+	// Upper bound of the bucket holding the given fraction of the recorded durations.
+	std::chrono::nanoseconds percentile( const double fraction ) const noexcept;
+
+	void merge( const LatencyHistogram& other ) noexcept;
+
+private:
+	static size_t bucket( const uint64_t value ) noexcept;
+	static uint64_t upperBound( const size_t bucket ) noexcept;
+
+	std::array< std::atomic< uint64_t >, buckets_count > _buckets{};
+	std::atomic< uint64_t > _count{0};
+	std::atomic< uint64_t > _max{0};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <endian.h>
+
+inline void writeU8( char* buffer, const uint8_t value )
+{
+	std::memcpy( buffer, &value, sizeof( value ) );
+}
+
+inline void writeI32( char* buffer, const int32_t value )
+{
+	const auto le = htole32( static_cast< uint32_t >( value ) );
+	std::memcpy( buffer, &le, sizeof( le ) );
+}
+
+inline void writeU32( char* buffer, const uint32_t value )
+{
+	const auto le = htole32( value );
+	std::memcpy( buffer, &le, sizeof( le ) );
+}
+
+inline void writeI64( char* buffer, const int64_t value )
+{
+	const auto le = htole64( static_cast< uint64_t >( value ) );
+	std::memcpy( buffer, &le, sizeof( le ) );
+}
+
+inline void writeU64( char* buffer, const uint64_t value )
+{
+	const auto le = htole64( value );
+	std::memcpy( buffer, &le, sizeof( le ) );
+}
+
+inline uint8_t readU8( const char* buffer )
+{
+	uint8_t value;
+	std::memcpy( &value, buffer, sizeof( value ) );
+	return value;
+}
+
+inline int32_t readI32( const char* buffer )
+{
+	uint32_t le;
+	std::memcpy( &le, buffer, sizeof( le ) );
+	return static_cast< int32_t >( le32toh( le ) );
+}
+
+inline uint32_t readU32( const char* buffer )
+{
+	uint32_t le;
+	std::memcpy( &le, buffer, sizeof( le ) );
+	return le32toh( le );
+}
+
+inline int64_t readI64( const char* buffer )
+{
+	uint64_t le;
+	std::memcpy( &le, buffer, sizeof( le ) );
+	return static_cast< int64_t >( le64toh( le ) );
+}
+
+inline uint64_t readU64( const char* buffer )
+{
+	uint64_t le;
+	std::memcpy( &le, buffer, sizeof( le ) );
+	return le64toh( le );
+}
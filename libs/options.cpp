@@ -0,0 +1,50 @@
+#include "options.h"
+
+#include <charconv>
+
+Options::Options( const int argc, char* argv[] )
+{
+	for ( int i = 1; i < argc; ++i ) {
+		const std::string_view argument( argv[ i ] );
+		if ( argument.substr( 0, 2 ) != "--" ) {
+			_positional.push_back( argument );
+			continue;
+		}
+
+		const auto option = argument.substr( 2 );
+		if ( const auto separator = option.find( '=' ); separator != std::string_view::npos ) {
+			_options[ option.substr( 0, separator ) ] = option.substr( separator + 1 );
+		}
+		else {
+			_options[ option ] = {};
+		}
+	}
+}
+
+const std::vector< std::string_view >& Options::positional() const noexcept
+{
+	return _positional;
+}
+
+bool Options::has( const std::string_view name ) const
+{
+	return _options.find( name ) != _options.cend();
+}
+
+std::string_view Options::value( const std::string_view name, const std::string_view default_value ) const
+{
+	if ( auto it = _options.find( name ); it != _options.cend() ) {
+		return it->second;
+	}
+	return default_value;
+}
+
+uint64_t Options::number( const std::string_view name, const uint64_t default_value ) const
+{
+	const auto text = value( name );
+	uint64_t result = default_value;
+	if ( const auto [ end, error ] = std::from_chars( text.data(), text.data() + text.size(), result ); error != std::errc() ) {
+		return default_value;
+	}
+	return result;
+}
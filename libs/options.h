@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Command line split into positional arguments and "--name=value" / "--name" options.
+class Options
+{
+public:
+	Options( const int argc, char* argv[] );
+
+	const std::vector< std::string_view >& positional() const noexcept;
+
+	bool has( const std::string_view name ) const;
+
+	std::string_view value( const std::string_view name, const std::string_view default_value = {} ) const;
+
+	uint64_t number( const std::string_view name, const uint64_t default_value ) const;
+
+private:
+	std::vector< std::string_view > _positional;
+	std::unordered_map< std::string_view, std::string_view > _options;
+};
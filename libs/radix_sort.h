@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "thread_pool.h"
+
+// Stable LSD radix sort by an unsigned integer key, one byte per pass. Every pass counts and scatters
+// contiguous blocks of items on the pool; passes whose byte is the same for all items are skipped.
+template < typename T, typename KeyFunction >
+void radixSort( ThreadPool& pool, std::vector< T >& items, const KeyFunction& key_function, const size_t key_bytes )
+{
+	constexpr size_t min_block_size = 16 * 1024;
+	using Histogram = std::array< size_t, 256 >;
+
+	const auto count = items.size();
+	const auto blocks = std::max< size_t >( 1, std::min( pool.concurrency(), count / min_block_size ) );
+	const auto block_size = ( count + blocks - 1 ) / blocks;
+
+	std::vector< T > buffer( count );
+	std::vector< Histogram > offsets( blocks );
+
+	for ( size_t pass = 0; pass < key_bytes; ++pass ) {
+		const auto digit = [&key_function, shift = 8 * pass]( const T& item ) {
+			return static_cast< size_t >( ( key_function( item ) >> shift ) & 0xFF );
+		};
+		const auto forBlocks = [&]( const auto& function ) {
+			pool.parallelFor( blocks, 1, [&]( const size_t block, const size_t ) {
+				function( offsets[ block ], block * block_size, std::min( count, ( block + 1 ) * block_size ) );
+			} );
+		};
+
+		forBlocks( [&]( Histogram& histogram, const size_t first, const size_t last ) {
+			histogram.fill( 0 );
+			for ( auto i = first; i < last; ++i ) {
+				++histogram[ digit( items[ i ] ) ];
+			}
+		} );
+
+		bool uniform = false;
+		size_t offset = 0;
+		for ( size_t value = 0; value < 256; ++value ) {
+			size_t total = 0;
+			for ( auto& histogram : offsets ) {
+				const auto items_count = histogram[ value ];
+				histogram[ value ] = offset;
+				offset += items_count;
+				total += items_count;
+			}
+			uniform = uniform || total == count;
+		}
+		if ( uniform ) {
+			continue;
+		}
+
+		forBlocks( [&]( Histogram& histogram, const size_t first, const size_t last ) {
+			for ( auto i = first; i < last; ++i ) {
+				buffer[ histogram[ digit( items[ i ] ) ]++ ] = items[ i ];
+			}
+		} );
+		items.swap( buffer );
+	}
+}
@@ -0,0 +1,95 @@
+#include "rank_bitmap.h"
+
+RankBitmap::RankBitmap( const size_t capacity )
+    : _capacity( capacity ), _words( ( capacity + 63 ) / 64 ), _counts( _words.size() + 1 )
+{
+	for ( _top_step = 1; _top_step * 2 <= _words.size(); _top_step *= 2 ) {
+	}
+}
+
+size_t RankBitmap::capacity() const noexcept
+{
+	return _capacity;
+}
+
+size_t RankBitmap::size() const noexcept
+{
+	return _size;
+}
+
+bool RankBitmap::contains( const size_t id ) const noexcept
+{
+	return id < _capacity && ( _words[ id / 64 ] >> ( id % 64 ) & 1 ) != 0;
+}
+
+bool RankBitmap::insert( const size_t id )
+{
+	if ( id >= _capacity || contains( id ) ) {
+		return false;
+	}
+	_words[ id / 64 ] |= uint64_t( 1 ) << ( id % 64 );
+	add( id / 64, 1 );
+	++_size;
+	return true;
+}
+
+bool RankBitmap::erase( const size_t id )
+{
+	if ( !contains( id ) ) {
+		return false;
+	}
+	_words[ id / 64 ] &= ~( uint64_t( 1 ) << ( id % 64 ) );
+	add( id / 64, -1 );
+	--_size;
+	return true;
+}
+
+size_t RankBitmap::rank( const size_t id ) const noexcept
+{
+	if ( id >= _capacity ) {
+		return _size;
+	}
+
+	size_t rank = static_cast< size_t >( __builtin_popcountll( _words[ id / 64 ] & ( ( uint64_t( 1 ) << ( id % 64 ) ) - 1 ) ) );
+	for ( auto i = id / 64; i > 0; i &= i - 1 ) {
+		rank += _counts[ i ];
+	}
+	return rank;
+}
+
+size_t RankBitmap::select( size_t index ) const noexcept
+{
+	size_t word = 0;
+	for ( auto step = _top_step; step > 0; step /= 2 ) {
+		if ( word + step <= _words.size() && _counts[ word + step ] <= index ) {
+			word += step;
+			index -= _counts[ word ];
+		}
+	}
+
+	auto bits = _words[ word ];
+	for ( ; index > 0; --index ) {
+		bits &= bits - 1;
+	}
+	return word * 64 + static_cast< size_t >( __builtin_ctzll( bits ) );
+}
+
+size_t RankBitmap::next( const size_t id ) const noexcept
+{
+	if ( id >= _capacity ) {
+		return _capacity;
+	}
+	if ( const auto bits = _words[ id / 64 ] >> ( id % 64 ); bits != 0 ) {
+		return id + static_cast< size_t >( __builtin_ctzll( bits ) );
+	}
+
+	const auto rank = this->rank( ( id / 64 + 1 ) * 64 );
+	return rank < _size ? select( rank ) : _capacity;
+}
+
+void RankBitmap::add( const size_t word, const int32_t delta ) noexcept
+{
+	for ( auto i = word + 1; i < _counts.size(); i += i & ( ~i + 1 ) ) {
+		_counts[ i ] += static_cast< uint32_t >( delta );
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set of ids in [0, capacity) kept as a bitmap with a Fenwick tree of per-word counts: membership
+// is O(1), rank() and select() are O(log capacity), and it costs about 1.5 bits per possible id.
+class RankBitmap
+{
+public:
+	explicit RankBitmap( const size_t capacity = 0 );
+
+	size_t capacity() const noexcept;
+	size_t size() const noexcept;
+
+	bool contains( const size_t id ) const noexcept;
+	// Both return false when nothing changed, also for ids out of range.
+	bool insert( const size_t id );
+	bool erase( const size_t id );
+
+	// Number of ids less than the given one.
+	size_t rank( const size_t id ) const noexcept;
+	// The index-th smallest id, index < size().
+	size_t select( size_t index ) const noexcept;
+	// Smallest id not less than the given one, or capacity() when there is none.
+	size_t next( const size_t id ) const noexcept;
+
+	template < typename Function >
+	void forEach( Function&& function ) const
+	{
+		for ( size_t word = 0; word < _words.size(); ++word ) {
+			for ( auto bits = _words[ word ]; bits != 0; bits &= bits - 1 ) {
+				function( word * 64 + static_cast< size_t >( __builtin_ctzll( bits ) ) );
+			}
+		}
+	}
+
+private:
+	void add( const size_t word, const int32_t delta ) noexcept;
+
+	size_t _capacity;
+	std::vector< uint64_t > _words;
+	std::vector< uint32_t > _counts;
+	size_t _top_step = 0;
+	size_t _size = 0;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "doorbell.h"
+
+// Bounded lock-free single-producer/single-consumer ring. A consumer serving several queues
+// can share one Doorbell between them and wait on all of them at once.
+template < typename T >
+class SpscQueue
+{
+public:
+	explicit SpscQueue( const size_t capacity, Doorbell* doorbell = nullptr )
+	    : _mask( roundUp( capacity ) - 1 ), _buffer( _mask + 1 ), _doorbell( doorbell ? *doorbell : _own_doorbell )
+	{
+	}
+
+	size_t capacity() const noexcept
+	{
+		return _buffer.size();
+	}
+
+	// May be called from a thread that is neither producer nor consumer: the head is read first, so
+	// that the consumer moving it past the tail read later cannot make the difference wrap.
+	size_t size() const noexcept
+	{
+		const auto head = _head.load( std::memory_order_acquire );
+		const auto tail = _tail.load( std::memory_order_acquire );
+		return std::min( tail - head, _buffer.size() );
+	}
+
+	bool empty() const noexcept
+	{
+		return _tail.load( std::memory_order_seq_cst ) == _head.load( std::memory_order_relaxed );
+	}
+
+	bool tryPush( T&& value )
+	{
+		const auto tail = _tail.load( std::memory_order_relaxed );
+		if ( tail - _head.load( std::memory_order_acquire ) == _buffer.size() ) {
+			return false;
+		}
+
+		_buffer[ tail & _mask ] = std::move( value );
+		_tail.store( tail + 1, std::memory_order_seq_cst );
+		_doorbell.ring();
+		return true;
+	}
+
+	void push( T&& value )
+	{
+		while ( !tryPush( std::move( value ) ) && !_doorbell.closed() ) {
+			std::this_thread::yield();
+		}
+	}
+
+	template < typename Consumer >
+	size_t drain( Consumer&& consumer, const size_t max_count = SIZE_MAX )
+	{
+		auto head = _head.load( std::memory_order_relaxed );
+		const auto count = std::min( _tail.load( std::memory_order_acquire ) - head, max_count );
+		for ( size_t i = 0; i < count; ++i, ++head ) {
+			T value = std::move( _buffer[ head & _mask ] );
+			_head.store( head + 1, std::memory_order_release );
+			consumer( std::move( value ) );
+		}
+		return count;
+	}
+
+	bool wait()
+	{
+		return _doorbell.wait( [this] { return !empty(); } );
+	}
+
+	void close()
+	{
+		_doorbell.close();
+	}
+
+private:
+	static size_t roundUp( const size_t value )
+	{
+		size_t result = 1;
+		while ( result < value ) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+	const size_t _mask;
+	std::vector< T > _buffer;
+
+	alignas( 64 ) std::atomic< size_t > _head{0};
+	alignas( 64 ) std::atomic< size_t > _tail{0};
+
+	Doorbell _own_doorbell;
+	Doorbell& _doorbell;
+};
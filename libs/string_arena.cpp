@@ -0,0 +1,46 @@
+#include "string_arena.h"
+
+#include <algorithm>
+
+StringArena::Span StringArena::append( const std::string_view text )
+{
+	const auto size = std::min( text.size(), chunk_size );
+	if ( _size % chunk_size + size > chunk_size ) {
+		_size += chunk_size - _size % chunk_size;
+	}
+
+	const auto chunk = _size / chunk_size;
+	if ( 0 == size ) {
+		return {};
+	}
+	if ( chunk >= max_chunks ) {
+		_dropped.store( _dropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		return {};
+	}
+	if ( !_chunks[ chunk ] ) {
+		_chunks[ chunk ] = std::make_unique< char[] >( chunk_size );
+	}
+
+	std::copy_n( text.data(), size, _chunks[ chunk ].get() + _size % chunk_size );
+	const Span span{static_cast< uint32_t >( _size ), static_cast< uint32_t >( size )};
+	_size += size;
+	return span;
+}
+
+std::string_view StringArena::view( const Span span ) const noexcept
+{
+	if ( 0 == span.size ) {
+		return {};
+	}
+	return {_chunks[ span.offset / chunk_size ].get() + span.offset % chunk_size, span.size};
+}
+
+size_t StringArena::size() const noexcept
+{
+	return _size;
+}
+
+uint64_t StringArena::dropped() const noexcept
+{
+	return _dropped.load( std::memory_order_relaxed );
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Append-only storage for short strings in fixed chunks. Stored bytes never move, so a Span handed
+// to another thread through a queue stays readable there while the owner keeps appending.
+class StringArena
+{
+public:
+	struct Span
+	{
+		uint32_t offset = 0;
+		uint32_t size = 0;
+	};
+
+	static constexpr size_t chunk_size = 1024 * 1024;
+	static constexpr size_t max_chunks = 4096;
+
+	// Strings longer than a chunk are truncated; returns an empty span once the arena is full.
+	Span append( const std::string_view text );
+	std::string_view view( const Span span ) const noexcept;
+
+	size_t size() const noexcept;
+
+	// Strings that got an empty span because the arena was full; safe to call from any thread.
+	uint64_t dropped() const noexcept;
+
+private:
+	std::array< std::unique_ptr< char[] >, max_chunks > _chunks;
+	size_t _size = 0;
+	std::atomic< uint64_t > _dropped{0};
+};
@@ -0,0 +1,76 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool( const size_t helpers )
+{
+	for ( size_t i = 0; i < helpers; ++i ) {
+		_threads.emplace_back( [this] { processing(); } );
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock lock( _mutex );
+		_stopped = true;
+	}
+	_start_condition.notify_all();
+	for ( auto& thread : _threads ) {
+		thread.join();
+	}
+}
+
+size_t ThreadPool::concurrency() const noexcept
+{
+	return _threads.size() + 1;
+}
+
+void ThreadPool::parallelFor( const size_t count, const size_t chunk, const std::function< void( size_t, size_t ) >& function )
+{
+	{
+		std::unique_lock lock( _mutex );
+		_function = &function;
+		_count = count;
+		_chunk = std::max< size_t >( 1, chunk );
+		_next.store( 0 );
+		_running = _threads.size();
+		++_generation;
+	}
+	_start_condition.notify_all();
+
+	runChunks();
+
+	std::unique_lock lock( _mutex );
+	_done_condition.wait( lock, [this] { return 0 == _running; } );
+	_function = nullptr;
+}
+
+void ThreadPool::processing()
+{
+	uint64_t generation = 0;
+	while ( true ) {
+		{
+			std::unique_lock lock( _mutex );
+			_start_condition.wait( lock, [this, generation] { return _stopped || _generation != generation; } );
+			if ( _stopped ) {
+				return;
+			}
+			generation = _generation;
+		}
+
+		runChunks();
+
+		std::unique_lock lock( _mutex );
+		if ( 0 == --_running ) {
+			_done_condition.notify_one();
+		}
+	}
+}
+
+void ThreadPool::runChunks()
+{
+	for ( auto first = _next.fetch_add( _chunk ); first < _count; first = _next.fetch_add( _chunk ) ) {
+		( *_function )( first, std::min( first + _chunk, _count ) );
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of helper threads for data-parallel loops. The calling thread takes part in the loop.
+class ThreadPool
+{
+public:
+	explicit ThreadPool( const size_t helpers );
+	~ThreadPool();
+
+	size_t concurrency() const noexcept;
+
+	// Calls function( first, last ) for consecutive chunks of [0, count); returns when all are done.
+	void parallelFor( const size_t count, const size_t chunk, const std::function< void( size_t, size_t ) >& function );
+
+private:
+	void processing();
+	void runChunks();
+
+	std::vector< std::thread > _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _start_condition;
+	std::condition_variable _done_condition;
+	bool _stopped = false;
+	uint64_t _generation = 0;
+	size_t _running = 0;
+
+	const std::function< void( size_t, size_t ) >* _function = nullptr;
+	size_t _count = 0;
+	size_t _chunk = 1;
+	std::atomic< size_t > _next{0};
+};
@@ -0,0 +1,204 @@
+#include "uring.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+template < typename T >
+T* ringPointer( void* rings, const uint32_t offset )
+{
+	return reinterpret_cast< T* >( static_cast< char* >( rings ) + offset );
+}
+
+// io_uring_buf_ring::bufs is declared through __DECLARE_FLEX_ARRAY, which C++ lays out after a one
+// byte empty struct; the kernel expects the entries at the start of the ring.
+struct io_uring_buf& ringEntry( struct io_uring_buf_ring* ring, const size_t index )
+{
+	return reinterpret_cast< struct io_uring_buf* >( ring )[ index ];
+}
+}
+
+std::unique_ptr< IoUring > IoUring::create( const unsigned entries )
+{
+	struct io_uring_params params{};
+	const auto fd = static_cast< int >( syscall( __NR_io_uring_setup, entries, &params ) );
+	if ( fd < 0 ) {
+		return nullptr;
+	}
+
+	std::unique_ptr< IoUring > ring( new IoUring() );
+	ring->_fd = fd;
+
+	constexpr uint32_t required_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_EXT_ARG;
+	if ( ( params.features & required_features ) != required_features ) {
+		return nullptr;
+	}
+
+	ring->_rings_size = std::max( params.sq_off.array + params.sq_entries * sizeof( unsigned ),
+	                              params.cq_off.cqes + params.cq_entries * sizeof( struct io_uring_cqe ) );
+	ring->_rings = mmap( nullptr, ring->_rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+	if ( MAP_FAILED == ring->_rings ) {
+		ring->_rings = nullptr;
+		return nullptr;
+	}
+
+	ring->_sqes_size = params.sq_entries * sizeof( struct io_uring_sqe );
+	const auto sqes = mmap( nullptr, ring->_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+	if ( MAP_FAILED == sqes ) {
+		return nullptr;
+	}
+	ring->_sqes = static_cast< struct io_uring_sqe* >( sqes );
+
+	auto* rings = ring->_rings;
+	ring->_sq_head = ringPointer< unsigned >( rings, params.sq_off.head );
+	ring->_sq_tail = ringPointer< unsigned >( rings, params.sq_off.tail );
+	ring->_sq_mask = ringPointer< unsigned >( rings, params.sq_off.ring_mask );
+	ring->_sq_array = ringPointer< unsigned >( rings, params.sq_off.array );
+	ring->_sq_entries = params.sq_entries;
+	ring->_tail = *ring->_sq_tail;
+	ring->_submitted = ring->_tail;
+
+	ring->_cq_head = ringPointer< unsigned >( rings, params.cq_off.head );
+	ring->_cq_tail = ringPointer< unsigned >( rings, params.cq_off.tail );
+	ring->_cq_mask = ringPointer< unsigned >( rings, params.cq_off.ring_mask );
+	ring->_cqes = ringPointer< struct io_uring_cqe >( rings, params.cq_off.cqes );
+
+	return ring;
+}
+
+IoUring::~IoUring()
+{
+	if ( _buffer_ring ) {
+		munmap( _buffer_ring, _buffer_ring_size );
+	}
+	if ( _sqes ) {
+		munmap( _sqes, _sqes_size );
+	}
+	if ( _rings ) {
+		munmap( _rings, _rings_size );
+	}
+	if ( _fd >= 0 ) {
+		close( _fd );
+	}
+}
+
+struct io_uring_sqe* IoUring::submission() noexcept
+{
+	if ( _tail - __atomic_load_n( _sq_head, __ATOMIC_ACQUIRE ) >= _sq_entries ) {
+		return nullptr;
+	}
+
+	const auto index = _tail & *_sq_mask;
+	auto* sqe = &_sqes[ index ];
+	std::memset( sqe, 0, sizeof( *sqe ) );
+	_sq_array[ index ] = index;
+	++_tail;
+	return sqe;
+}
+
+int IoUring::submit( const unsigned wait_count, const std::chrono::nanoseconds timeout )
+{
+	__atomic_store_n( _sq_tail, _tail, __ATOMIC_RELEASE );
+
+	const auto pending = _tail - _submitted;
+	unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+	struct __kernel_timespec timespec{};
+	struct io_uring_getevents_arg argument{};
+	const void* arguments = nullptr;
+	size_t arguments_size = 0;
+	if ( wait_count > 0 && timeout.count() > 0 ) {
+		timespec.tv_sec = timeout.count() / 1000000000;
+		timespec.tv_nsec = timeout.count() % 1000000000;
+		argument.ts = reinterpret_cast< uint64_t >( &timespec );
+		arguments = &argument;
+		arguments_size = sizeof( argument );
+		flags |= IORING_ENTER_EXT_ARG;
+	}
+
+	++_calls;
+	const auto result = static_cast< int >( syscall( __NR_io_uring_enter, _fd, pending, wait_count, flags, arguments, arguments_size ) );
+	if ( result > 0 ) {
+		_submitted += static_cast< unsigned >( result );
+	}
+	return result;
+}
+
+unsigned IoUring::discardUnsubmitted() noexcept
+{
+	const auto discarded = _tail - _submitted;
+	_tail = _submitted;
+	__atomic_store_n( _sq_tail, _tail, __ATOMIC_RELEASE );
+	return discarded;
+}
+
+bool IoUring::provideBuffers( const size_t count, const size_t size )
+{
+	if ( _buffer_ring || 0 == count || count > 32768 || ( count & ( count - 1 ) ) != 0 ) {
+		return false;
+	}
+
+	_buffer_ring_size = count * sizeof( struct io_uring_buf );
+	const auto memory = mmap( nullptr, _buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( MAP_FAILED == memory ) {
+		return false;
+	}
+	_buffer_ring = static_cast< struct io_uring_buf_ring* >( memory );
+
+	struct io_uring_buf_reg registration{};
+	registration.ring_addr = reinterpret_cast< uint64_t >( _buffer_ring );
+	registration.ring_entries = static_cast< uint32_t >( count );
+	registration.bgid = buffer_group;
+	if ( syscall( __NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, &registration, 1 ) < 0 ) {
+		munmap( _buffer_ring, _buffer_ring_size );
+		_buffer_ring = nullptr;
+		return false;
+	}
+
+	_buffer_size = size;
+	_buffers.resize( count * size );
+	for ( size_t i = 0; i < count; ++i ) {
+		auto& buffer = ringEntry( _buffer_ring, i );
+		buffer.addr = reinterpret_cast< uint64_t >( _buffers.data() + i * size );
+		buffer.len = static_cast< uint32_t >( size );
+		buffer.bid = static_cast< uint16_t >( i );
+	}
+	_buffer_tail = static_cast< uint16_t >( count );
+	__atomic_store_n( &_buffer_ring->tail, _buffer_tail, __ATOMIC_RELEASE );
+	return true;
+}
+
+std::string_view IoUring::buffer( const struct io_uring_cqe& cqe ) const noexcept
+{
+	if ( !( cqe.flags & IORING_CQE_F_BUFFER ) || cqe.res <= 0 ) {
+		return {};
+	}
+	const auto id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+	return {_buffers.data() + id * _buffer_size, static_cast< size_t >( cqe.res )};
+}
+
+void IoUring::recycle( const struct io_uring_cqe& cqe ) noexcept
+{
+	if ( !( cqe.flags & IORING_CQE_F_BUFFER ) ) {
+		return;
+	}
+
+	const auto id = static_cast< uint16_t >( cqe.flags >> IORING_CQE_BUFFER_SHIFT );
+	const auto mask = static_cast< uint16_t >( _buffers.size() / _buffer_size - 1 );
+	auto& buffer = ringEntry( _buffer_ring, _buffer_tail & mask );
+	buffer.addr = reinterpret_cast< uint64_t >( _buffers.data() + id * _buffer_size );
+	buffer.len = static_cast< uint32_t >( _buffer_size );
+	buffer.bid = id;
+	++_buffer_tail;
+	__atomic_store_n( &_buffer_ring->tail, _buffer_tail, __ATOMIC_RELEASE );
+}
+
+uint64_t IoUring::calls() const noexcept
+{
+	return _calls;
+}
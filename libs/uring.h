@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+// Minimal io_uring on raw syscalls: one submission ring, one completion ring and an optional ring of
+// provided buffers that multishot receives pick their buffers from. Used by a single thread.
+class IoUring
+{
+public:
+	// Returns nullptr when io_uring or a feature it relies on is not available.
+	static std::unique_ptr< IoUring > create( const unsigned entries );
+	~IoUring();
+
+	IoUring( const IoUring& ) = delete;
+	IoUring& operator=( const IoUring& ) = delete;
+
+	// Next free submission entry, zeroed, or nullptr when the submission ring is full.
+	struct io_uring_sqe* submission() noexcept;
+
+	// Submits the prepared entries and waits for at least wait_count completions, or for the timeout
+	// when it is not zero. Returns the io_uring_enter result.
+	int submit( const unsigned wait_count = 0, const std::chrono::nanoseconds timeout = std::chrono::nanoseconds::zero() );
+
+	// Takes back the prepared entries the kernel has not consumed yet; returns their number.
+	unsigned discardUnsubmitted() noexcept;
+
+	// Calls handler( cqe ) for every available completion; returns their number.
+	template < typename Handler >
+	size_t complete( Handler&& handler )
+	{
+		const auto first = *_cq_head;
+		const auto tail = __atomic_load_n( _cq_tail, __ATOMIC_ACQUIRE );
+		for ( auto head = first; head != tail; ++head ) {
+			handler( _cqes[ head & *_cq_mask ] );
+		}
+		__atomic_store_n( _cq_head, tail, __ATOMIC_RELEASE );
+		return tail - first;
+	}
+
+	// Registers count buffers of the given size as buffer group `buffer_group`.
+	bool provideBuffers( const size_t count, const size_t size );
+	std::string_view buffer( const struct io_uring_cqe& cqe ) const noexcept;
+	// Hands the buffer of a completion back to the kernel.
+	void recycle( const struct io_uring_cqe& cqe ) noexcept;
+
+	uint64_t calls() const noexcept;
+
+	static constexpr uint16_t buffer_group = 0;
+
+private:
+	IoUring() = default;
+
+	int _fd = -1;
+	void* _rings = nullptr;
+	size_t _rings_size = 0;
+	struct io_uring_sqe* _sqes = nullptr;
+	size_t _sqes_size = 0;
+
+	unsigned* _sq_head = nullptr;
+	unsigned* _sq_tail = nullptr;
+	unsigned* _sq_mask = nullptr;
+	unsigned* _sq_array = nullptr;
+	unsigned _sq_entries = 0;
+	unsigned _tail = 0;
+	unsigned _submitted = 0;
+
+	unsigned* _cq_head = nullptr;
+	unsigned* _cq_tail = nullptr;
+	unsigned* _cq_mask = nullptr;
+	struct io_uring_cqe* _cqes = nullptr;
+
+	struct io_uring_buf_ring* _buffer_ring = nullptr;
+	size_t _buffer_ring_size = 0;
+	uint16_t _buffer_tail = 0;
+	size_t _buffer_size = 0;
+	std::vector< char > _buffers;
+
+	uint64_t _calls = 0;
+};
@@ -0,0 +1,66 @@
+#include "broadcaster.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+Broadcaster::Broadcaster( PacketsHandler& packets_handler, const size_t threads, const size_t max_silence, const size_t chunk_size )
+    : _snapshots( 4 )
+    , _pool( std::max< size_t >( 1, threads ) - 1 )
+    , _chunk_size( chunk_size )
+    , _view_tracker( max_silence > 0 ? std::make_unique< ViewTracker >( max_silence ) : nullptr )
+    , _packets_handler( packets_handler )
+    , _thread( [this] { processing(); } )
+{
+}
+
+Broadcaster::~Broadcaster()
+{
+	_snapshots.close();
+	_thread.join();
+
+	if ( _view_tracker ) {
+		std::cerr << "left " << _view_tracker->skipped() << " unchanged views out of broadcasts\n";
+	}
+}
+
+void Broadcaster::put( std::unique_ptr< LeaderboardSnapshot > snapshot )
+{
+	_snapshots.push( std::move( snapshot ) );
+}
+
+void Broadcaster::processing()
+{
+	while ( _snapshots.wait() ) {
+		_snapshots.drain( [this]( std::unique_ptr< LeaderboardSnapshot >&& snapshot ) { build( *snapshot ); } );
+	}
+}
+
+void Broadcaster::build( LeaderboardSnapshot& snapshot )
+{
+	snapshot.rank( _pool );
+
+	std::vector< size_t > users( snapshot.connected.size() );
+	std::iota( users.begin(), users.end(), 0 );
+	if ( _view_tracker ) {
+		_view_tracker->startBroadcast( std::move( snapshot.changed ), snapshot.top );
+		users.erase( std::remove_if( users.begin(),
+		                             users.end(),
+		                             [this, &snapshot]( const size_t i ) { return !_view_tracker->needsPacket( snapshot.connected[ i ].first ); } ),
+		             users.end() );
+	}
+
+	std::vector< Packet > packets( users.size() );
+	_pool.parallelFor( packets.size(), _chunk_size, [&snapshot, &users, &packets]( const size_t first, const size_t last ) {
+		for ( auto i = first; i < last; ++i ) {
+			packets[ i ] = snapshot.packet( users[ i ] );
+		}
+	} );
+
+	if ( _view_tracker ) {
+		std::for_each( packets.cbegin(), packets.cend(), [this]( const Packet& packet ) { _view_tracker->sent( packet ); } );
+		_view_tracker->finishBroadcast( snapshot.connected.size() );
+	}
+
+	_packets_handler.putBroadcast( std::move( packets ) );
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <libs/spsc_queue.h>
+#include <libs/thread_pool.h>
+
+#include "leaderboard_snapshot.h"
+#include "packets_handler.h"
+#include "view_tracker.h"
+
+// Builds minute broadcasts from leaderboard snapshots on a thread pool, off the events thread,
+// and hands each finished broadcast to the PacketsHandler in one piece.
+class Broadcaster
+{
+public:
+	static constexpr size_t default_chunk_size = 256;
+
+	// With max_silence, users whose view did not change are left out of broadcasts, see ViewTracker.
+	Broadcaster( PacketsHandler& packets_handler,
+	             const size_t threads,
+	             const size_t max_silence = 0,
+	             const size_t chunk_size = default_chunk_size );
+	~Broadcaster();
+
+	void put( std::unique_ptr< LeaderboardSnapshot > snapshot );
+
+private:
+	void processing();
+
+	void build( LeaderboardSnapshot& snapshot );
+
+	SpscQueue< std::unique_ptr< LeaderboardSnapshot > > _snapshots;
+	ThreadPool _pool;
+	const size_t _chunk_size;
+	std::unique_ptr< ViewTracker > _view_tracker;
+
+	PacketsHandler& _packets_handler;
+	std::thread _thread;
+};
@@ -0,0 +1,241 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libs/little_endian.h>
+
+namespace
+{
+constexpr char magic[ 8 ] = {'L', 'B', 'C', 'H', 'K', 'P', 'T', '\0'};
+constexpr size_t header_size = 64;
+constexpr size_t entry_size = 16;
+constexpr size_t name_size = 16;
+
+size_t alignUp( const size_t size )
+{
+	return ( size + 7 ) & ~size_t( 7 );
+}
+}
+
+bool writeCheckpoint( const std::string& path, const CheckpointState& state, const StringArena& names )
+{
+	size_t name_bytes = 0;
+	for ( const auto& [ user, span ] : state.names ) {
+		name_bytes += span.size;
+	}
+
+	const auto entries_offset = header_size;
+	const auto names_offset = entries_offset + state.entries.size() * entry_size;
+	const auto name_bytes_offset = names_offset + state.names.size() * name_size;
+	const auto size = alignUp( name_bytes_offset + name_bytes );
+
+	const auto temporary_path = path + ".tmp";
+	const auto fd = ::open( temporary_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+	if ( fd < 0 ) {
+		return false;
+	}
+	if ( ftruncate( fd, static_cast< off_t >( size ) ) < 0 ) {
+		close( fd );
+		return false;
+	}
+	const auto memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	if ( MAP_FAILED == memory ) {
+		close( fd );
+		return false;
+	}
+
+	auto* data = static_cast< char* >( memory );
+	std::memcpy( data, magic, sizeof( magic ) );
+	writeU32( data + 8, CheckpointFile::version );
+	writeU64( data + 16, state.entries.size() );
+	writeU64( data + 24, state.names.size() );
+	writeU64( data + 32, name_bytes );
+	writeI64( data + 40, state.last_deal_time.count() );
+	writeI64( data + 48, state.week_time.count() );
+	writeI64( data + 56, state.week.value_or( -1 ) );
+
+	auto* entry = data + entries_offset;
+	for ( const auto& [ amount, user ] : state.entries ) {
+		writeI64( entry, amount );
+		writeI32( entry + 8, user );
+		entry += entry_size;
+	}
+
+	auto* name = data + names_offset;
+	size_t offset = 0;
+	for ( const auto& [ user, span ] : state.names ) {
+		const auto text = names.view( span );
+		writeI32( name, user );
+		writeU32( name + 4, static_cast< uint32_t >( text.size() ) );
+		writeU64( name + 8, offset );
+		std::copy( text.cbegin(), text.cend(), data + name_bytes_offset + offset );
+		offset += text.size();
+		name += name_size;
+	}
+
+	munmap( memory, size );
+	const auto synced = 0 == fsync( fd );
+	close( fd );
+	return synced && 0 == rename( temporary_path.c_str(), path.c_str() );
+}
+
+std::unique_ptr< CheckpointFile > CheckpointFile::open( const std::string& path )
+{
+	const auto fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+	if ( fd < 0 ) {
+		return nullptr;
+	}
+
+	struct stat status{};
+	if ( fstat( fd, &status ) < 0 || static_cast< size_t >( status.st_size ) < header_size ) {
+		close( fd );
+		return nullptr;
+	}
+
+	const auto size = static_cast< size_t >( status.st_size );
+	const auto memory = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( MAP_FAILED == memory ) {
+		return nullptr;
+	}
+	madvise( memory, size, MADV_WILLNEED );
+
+	std::unique_ptr< CheckpointFile > file( new CheckpointFile() );
+	file->_data = static_cast< const char* >( memory );
+	file->_size = size;
+
+	const auto* data = file->_data;
+	if ( std::memcmp( data, magic, sizeof( magic ) ) != 0 || readU32( data + 8 ) != version ) {
+		return nullptr;
+	}
+
+	file->_entries = readU64( data + 16 );
+	file->_names = readU64( data + 24 );
+	file->_name_bytes = readU64( data + 32 );
+	const auto records = ( size - header_size ) / entry_size;
+	if ( file->_entries > records || file->_names > records - file->_entries
+	     || file->_name_bytes > size - header_size - ( file->_entries + file->_names ) * entry_size ) {
+		return nullptr;
+	}
+
+	file->_entries_data = data + header_size;
+	file->_names_data = file->_entries_data + file->_entries * entry_size;
+	file->_name_bytes_data = file->_names_data + file->_names * name_size;
+	return file;
+}
+
+CheckpointFile::~CheckpointFile()
+{
+	if ( _data ) {
+		munmap( const_cast< char* >( _data ), _size );
+	}
+}
+
+size_t CheckpointFile::entries() const noexcept
+{
+	return _entries;
+}
+
+StatisticsEntry CheckpointFile::entry( const size_t index ) const noexcept
+{
+	const auto* entry = _entries_data + index * entry_size;
+	return {readI64( entry ), readI32( entry + 8 )};
+}
+
+size_t CheckpointFile::names() const noexcept
+{
+	return _names;
+}
+
+std::pair< Event::User, std::string_view > CheckpointFile::name( const size_t index ) const noexcept
+{
+	const auto* name = _names_data + index * name_size;
+	const auto size = readU32( name + 4 );
+	const auto offset = readU64( name + 8 );
+	if ( offset > _name_bytes || size > _name_bytes - offset ) {
+		return {readI32( name ), {}};
+	}
+	return {readI32( name ), {_name_bytes_data + offset, size}};
+}
+
+std::chrono::nanoseconds CheckpointFile::lastDealTime() const noexcept
+{
+	return std::chrono::nanoseconds( readI64( _data + 40 ) );
+}
+
+std::chrono::nanoseconds CheckpointFile::weekTime() const noexcept
+{
+	return std::chrono::nanoseconds( readI64( _data + 48 ) );
+}
+
+std::optional< int64_t > CheckpointFile::week() const noexcept
+{
+	const auto week = readI64( _data + 56 );
+	return week < 0 ? std::nullopt : std::optional< int64_t >( week );
+}
+
+CheckpointWriter::CheckpointWriter( std::string path, const StringArena& names )
+    : _path( std::move( path ) ), _names( names ), _states( 1 ), _thread( [this] { processing(); } )
+{
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	_states.close();
+	_thread.join();
+}
+
+bool CheckpointWriter::put( std::unique_ptr< CheckpointState > state )
+{
+	if ( _writing.exchange( true, std::memory_order_acq_rel ) ) {
+		return false;
+	}
+	_states.push( std::move( state ) );
+	return true;
+}
+
+bool CheckpointWriter::writing() const noexcept
+{
+	return _writing.load( std::memory_order_acquire );
+}
+
+bool CheckpointWriter::write( const CheckpointState& state )
+{
+	while ( writing() ) {
+		std::this_thread::yield();
+	}
+
+	return save( state );
+}
+
+uint64_t CheckpointWriter::written() const noexcept
+{
+	return _written.load( std::memory_order_relaxed );
+}
+
+void CheckpointWriter::processing()
+{
+	while ( _states.wait() ) {
+		_states.drain( [this]( std::unique_ptr< CheckpointState >&& state ) {
+			save( *state );
+			_writing.store( false, std::memory_order_release );
+		} );
+	}
+}
+
+bool CheckpointWriter::save( const CheckpointState& state )
+{
+	if ( !writeCheckpoint( _path, state, _names ) ) {
+		std::cerr << "Cannot write checkpoint " << _path << ".\n";
+		return false;
+	}
+	_written.fetch_add( 1, std::memory_order_relaxed );
+	return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <libs/event.h>
+#include <libs/spsc_queue.h>
+#include <libs/string_arena.h>
+
+#include "statistics.h"
+
+// State a restarted service resumes from: every known user with this week's amount, the names of
+// registered users, the time of the latest deal applied and the week the amounts belong to.
+struct CheckpointState
+{
+	std::vector< StatisticsEntry > entries;
+	// Spans into the arena given to writeCheckpoint().
+	std::vector< std::pair< Event::User, StringArena::Span > > names;
+	std::chrono::nanoseconds last_deal_time{};
+	std::chrono::nanoseconds week_time{};
+	// Weeks counted from the epoch, none before the first deal.
+	std::optional< int64_t > week;
+};
+
+// File layout, little-endian, with every section 8-byte aligned so that the file is read in place:
+// 64 byte header: 8 byte magic, u32 version, u32 reserved, u64 entries count, u64 names count,
+// u64 name bytes, i64 last deal time, i64 week time, i64 week or -1 when there is none;
+// entries: i64 amount, i32 user, u32 reserved;
+// names: i32 user, u32 size, u64 offset into the name bytes;
+// name bytes.
+// The file is written next to the target and renamed over it, so a crash leaves the previous one.
+bool writeCheckpoint( const std::string& path, const CheckpointState& state, const StringArena& names );
+
+// Checkpoint file mapped read-only.
+class CheckpointFile
+{
+public:
+	static constexpr uint32_t version = 2;
+
+	// Returns nullptr when the file is missing, has another version or is truncated.
+	static std::unique_ptr< CheckpointFile > open( const std::string& path );
+	~CheckpointFile();
+
+	CheckpointFile( const CheckpointFile& ) = delete;
+	CheckpointFile& operator=( const CheckpointFile& ) = delete;
+
+	size_t entries() const noexcept;
+	StatisticsEntry entry( const size_t index ) const noexcept;
+
+	size_t names() const noexcept;
+	std::pair< Event::User, std::string_view > name( const size_t index ) const noexcept;
+
+	std::chrono::nanoseconds lastDealTime() const noexcept;
+	std::chrono::nanoseconds weekTime() const noexcept;
+	std::optional< int64_t > week() const noexcept;
+
+private:
+	CheckpointFile() = default;
+
+	const char* _data = nullptr;
+	size_t _size = 0;
+
+	size_t _entries = 0;
+	size_t _names = 0;
+	size_t _name_bytes = 0;
+	const char* _entries_data = nullptr;
+	const char* _names_data = nullptr;
+	const char* _name_bytes_data = nullptr;
+};
+
+// Writes checkpoints on its own thread, so the events thread only pays for copying the state.
+class CheckpointWriter
+{
+public:
+	CheckpointWriter( std::string path, const StringArena& names );
+	~CheckpointWriter();
+
+	// Returns false, dropping the state, while the previous checkpoint is still being written.
+	bool put( std::unique_ptr< CheckpointState > state );
+
+	bool writing() const noexcept;
+
+	// Waits for the background write, then writes the state on the calling thread.
+	bool write( const CheckpointState& state );
+
+	uint64_t written() const noexcept;
+
+private:
+	void processing();
+	bool save( const CheckpointState& state );
+
+	const std::string _path;
+	const StringArena& _names;
+
+	SpscQueue< std::unique_ptr< CheckpointState > > _states;
+	std::atomic< bool > _writing{false};
+	std::atomic< uint64_t > _written{0};
+	std::thread _thread;
+};
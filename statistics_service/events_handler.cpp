@@ -1,70 +1,267 @@
 #include "events_handler.h"
 
 #include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <type_traits>
 
-EventsHandler::EventsHandler( PacketsHandler& packetsHandler ) : _packets_handler( packetsHandler )
+EventsHandler::Shard::Shard( const size_t queue_capacity, const bool track_changes, const size_t dense_users )
+    : leaderboard( dense_users ), track_changes( track_changes ), events( queue_capacity )
 {
 }
 
-void EventsHandler::put( std::unique_ptr< Event >&& event )
+EventsHandler::EventsHandler( PacketsHandler& packetsHandler, const EventsHandlerConfig& config )
+    : _dense_users( config.dense_users )
+    , _registered_users( config.dense_users )
+    , _carry_names( config.names )
+    , _connected_users( config.dense_users )
+    , _track_changes( config.max_silence > 0 )
+    , _packets_handler( packetsHandler )
+    , _timed_broadcasts( config.timed_broadcasts )
+    , _record_broadcasts( config.record_broadcasts )
+    , _checkpoint_period( config.checkpoint_period )
 {
-	std::unique_lock lock( _mutex );
-	_unhandled_events.push_back( std::move( event ) );
-	_condition_variable.notify_one();
+	for ( size_t i = 0; i < std::max< size_t >( 1, config.inputs ); ++i ) {
+		_unhandled_events.push_back( std::make_unique< SpscQueue< Event > >( config.queue_capacity, &_events_doorbell ) );
+	}
+
+	// Dense per-user arrays are indexed by user id, so they are not split between shards.
+	const auto shards = _dense_users > 0 ? 1 : std::max< size_t >( 1, config.workers );
+	for ( size_t i = 0; i < shards; ++i ) {
+		_shards.push_back( std::make_unique< Shard >( shards > 1 ? config.queue_capacity : 1, _track_changes, _dense_users ) );
+	}
+
+	if ( _carry_names ) {
+		_packets_handler.setNames( &_names );
+	}
+
+	if ( !config.checkpoint_path.empty() ) {
+		restore( config.checkpoint_path );
+		_checkpoint_writer = std::make_unique< CheckpointWriter >( config.checkpoint_path, _names );
+		_last_checkpoint = std::chrono::steady_clock::now();
+	}
+
+	if ( config.broadcast_threads > 0 ) {
+		_broadcaster = std::make_unique< Broadcaster >( _packets_handler, config.broadcast_threads, config.max_silence );
+	}
+	else if ( _track_changes ) {
+		_view_tracker = std::make_unique< ViewTracker >( config.max_silence );
+	}
+
+	if ( shards > 1 ) {
+		for ( auto& shard : _shards ) {
+			shard->thread = std::thread( [this, &shard = *shard] { shardProcessing( shard ); } );
+		}
+	}
+}
+
+EventsHandler::~EventsHandler()
+{
+	// Shards are still running here, so the final checkpoint includes every routed event.
+	if ( _checkpoint_writer ) {
+		_checkpoint_writer->write( *checkpointState() );
+	}
+
+	for ( auto& shard : _shards ) {
+		shard->events.close();
+		if ( shard->thread.joinable() ) {
+			shard->thread.join();
+		}
+	}
+
+	if ( _checkpoint_writer ) {
+		std::cerr << "wrote " << _checkpoint_writer->written() << " checkpoints\n";
+	}
+	if ( _replayed_deals > 0 ) {
+		std::cerr << "skipped " << _replayed_deals << " replayed deals already in the restored checkpoint\n";
+	}
+
+	if ( _view_tracker ) {
+		std::cerr << "left " << _view_tracker->skipped() << " unchanged views out of broadcasts\n";
+	}
+	if ( _previous_week_deals > 0 ) {
+		std::cerr << "dropped " << _previous_week_deals << " deals of the previous week that came after the rollover\n";
+	}
+	if ( _names.dropped() > 0 ) {
+		std::cerr << "dropped " << _names.dropped() << " names that did not fit into the names arena\n";
+	}
+	if ( _ignored_events > 0 ) {
+		std::cerr << "ignored " << _ignored_events << " events of users outside the dense id range\n";
+	}
+}
+
+void EventsHandler::put( const Event& event, const size_t input )
+{
+	_unhandled_events[ input ]->push( Event( event ) );
 }
 
 void EventsHandler::procesing()
 {
-	_stopped.store( false );
-	while ( pop() ) {
-		for ( const auto& event : _processing_events ) {
-			switch ( event->type() ) {
-				case Event::Type::undefined: {
-					break;
-				}
-				case Event::Type::user_registered: {
-					registered( static_cast< UserRegisteredEvent& >( *event ) );
-					break;
-				}
-				case Event::Type::user_renamed: {
-					renamed( static_cast< UserRenamedEvent& >( *event ) );
-					break;
-				}
-				case Event::Type::user_deal_won: {
-					dealWon( static_cast< UserDealWonEvent& >( *event ) );
-					break;
-				}
-				case Event::Type::user_connected: {
-					connected( static_cast< UserConnectedEvent& >( *event ) );
-					break;
-				}
-				case Event::Type::user_disconnected: {
-					disconnected( static_cast< UserDisconnectedEvent& >( *event ) );
-					break;
-				}
+	constexpr size_t input_drain_limit = 256;
+
+	const auto ready = [this] {
+		return std::any_of( _unhandled_events.cbegin(), _unhandled_events.cend(), []( const auto& events ) { return !events->empty(); } );
+	};
+	while ( _events_doorbell.wait( ready ) ) {
+		_drain_timer.measure( [this] {
+			for ( auto& events : _unhandled_events ) {
+				events->drain( [this]( Event&& event ) { handle( event ); }, input_drain_limit );
 			}
-		}
+			flushConnects();
+		} );
 	}
 }
 
 void EventsHandler::stopProcessing()
 {
-	_stopped.store( true );
-	_condition_variable.notify_one();
+	_events_doorbell.close();
+}
+
+void EventsHandler::handle( const Event& event )
+{
+	if ( _dense_users > 0 && static_cast< uint64_t >( static_cast< uint32_t >( event.user() ) ) >= _dense_users ) {
+		++_ignored_events;
+		return;
+	}
+	if ( event.type() != Event::Type::undefined ) {
+		_handled_events[ static_cast< size_t >( event.type() ) ].add();
+	}
+
+	event.visit( [this]( const auto& value ) {
+		using Value = std::decay_t< decltype( value ) >;
+		if constexpr ( std::is_same_v< Value, UserRegisteredEvent > ) {
+			registered( value );
+		}
+		else if constexpr ( std::is_same_v< Value, UserRenamedEvent > ) {
+			renamed( value );
+		}
+		else if constexpr ( std::is_same_v< Value, UserDealWonEvent > ) {
+			dealWon( value );
+		}
+		else if constexpr ( std::is_same_v< Value, UserConnectedEvent > ) {
+			connected( value );
+		}
+		else if constexpr ( std::is_same_v< Value, UserDisconnectedEvent > ) {
+			disconnected( value );
+		}
+	} );
+}
+
+void EventsHandler::shardProcessing( Shard& shard )
+{
+	while ( shard.events.wait() ) {
+		const auto count = shard.events.drain( [&shard]( Event&& event ) { apply( shard, event ); } );
+		shard.applied.fetch_add( count, std::memory_order_release );
+	}
+}
+
+void EventsHandler::apply( Shard& shard, const Event& event )
+{
+	if ( const auto* deal = event.get< UserDealWonEvent >(); deal ) {
+		const auto users = shard.leaderboard.size();
+		const auto [ last, current ] = shard.leaderboard.addAmount( deal->user(), deal->amount() );
+		if ( shard.track_changes ) {
+			markChanged( shard.changed, users != shard.leaderboard.size(), last, current );
+		}
+	}
+	else if ( event.get< UserRegisteredEvent >() ) {
+		if ( shard.leaderboard.addUser( event.user() ) && shard.track_changes ) {
+			shard.changed.markInserted( {0, event.user()} );
+		}
+	}
+	else if ( event.get< UserRenamedEvent >() ) {
+		if ( const auto entry = shard.leaderboard.entry( event.user() ); entry && shard.track_changes ) {
+			shard.changed.markEntry( *entry );
+		}
+	}
+}
+
+// Deals of users that were never registered add them to the leaderboard.
+void EventsHandler::markChanged( DirtyRanges& changed, const bool inserted, const StatisticsEntry& last, const StatisticsEntry& current )
+{
+	if ( inserted ) {
+		changed.markInserted( current );
+	}
+	else {
+		changed.markMoved( last, current );
+	}
+}
+
+EventsHandler::Shard& EventsHandler::userShard( const Event::User user ) noexcept
+{
+	const auto hash = ( static_cast< uint64_t >( static_cast< uint32_t >( user ) ) * 0x9E3779B97F4A7C15ull ) >> 32;
+	return *_shards[ hash % _shards.size() ];
+}
+
+const EventsHandler::Shard& EventsHandler::userShard( const Event::User user ) const noexcept
+{
+	return const_cast< EventsHandler& >( *this ).userShard( user );
+}
+
+void EventsHandler::route( const Event& event )
+{
+	auto& shard = userShard( event.user() );
+	++shard.routed;
+	shard.events.push( Event( event ) );
+	_top_dirty = true;
+}
+
+void EventsHandler::synchronize()
+{
+	if ( _shards.size() > 1 ) {
+		for ( const auto& shard : _shards ) {
+			while ( shard->applied.load( std::memory_order_acquire ) != shard->routed ) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	if ( _top_dirty ) {
+		_top_dirty = false;
+		resetTopStatistic();
+	}
+
+	for ( const auto user : _pending_connects ) {
+		sendStatistic( user );
+	}
+	_pending_connects.clear();
 }
 
-bool EventsHandler::pop()
+void EventsHandler::broadcast()
 {
-	_processing_events.clear();
-	std::unique_lock lock( _mutex );
-	_condition_variable.wait( lock, [this] { return _stopped.load() || !_unhandled_events.empty(); } );
+	sendPackets();
+}
 
-	if ( !_stopped.load() ) {
-		_processing_events.push_back( std::move( _unhandled_events.front() ) );
-		_unhandled_events.pop_front();
+const std::vector< BroadcastTime >& EventsHandler::broadcastTimes() const noexcept
+{
+	return _broadcast_times;
+}
+
+void EventsHandler::writeMetrics( MetricsWriter& writer ) const
+{
+	static constexpr std::array< std::string_view, std::tuple_size_v< decltype( _handled_events ) > > names = {
+	    "registered", "renamed", "deal_won", "connected", "disconnected"};
+
+	size_t queued = 0;
+	for ( const auto& events : _unhandled_events ) {
+		queued += events->size();
+	}
+	writer.gauge( "events.queued", queued );
+	if ( _shards.size() > 1 ) {
+		size_t routed = 0;
+		for ( const auto& shard : _shards ) {
+			routed += shard->events.size();
+		}
+		writer.gauge( "events.shards_queued", routed );
 	}
 
-	return !_stopped.load();
+	for ( size_t i = 0; i < names.size(); ++i ) {
+		writer.counter( "events." + std::string( names[ i ] ), _handled_events[ i ].load() );
+	}
+	writer.counter( "events.names_dropped", _names.dropped() );
+	writer.histogram( "events.drain", _drain_timer.histogram() );
+	writer.histogram( "events.broadcast", _broadcast_histogram );
 }
 
 void EventsHandler::registered( const UserRegisteredEvent& event )
@@ -74,18 +271,38 @@ void EventsHandler::registered( const UserRegisteredEvent& event )
 
 void EventsHandler::connected( const UserConnectedEvent& event )
 {
-	_connected_users.emplace( event.user() );
+	_connected_users.insert( event.user() );
 
 	sendUserStatistics( event.user() );
 }
 
 void EventsHandler::renamed( const UserRenamedEvent& event )
 {
-	_registered_users[ event.user() ] = event.name();
+	_registered_users.tryEmplace( event.user() ).first = _names.append( event.name() );
+	if ( !_carry_names ) {
+		return;
+	}
+
+	// Views showing the user carry its old name now.
+	resetTopStatistic();
+	if ( _track_changes ) {
+		if ( _shards.size() > 1 ) {
+			route( event );
+		}
+		else if ( const auto entry = userEntry( event.user() ); entry ) {
+			_changed.markEntry( *entry );
+		}
+	}
 }
 
 void EventsHandler::dealWon( const UserDealWonEvent& event )
 {
+	if ( _checkpoint_time && event.time() <= *_checkpoint_time ) {
+		++_replayed_deals;
+		return;
+	}
+	_last_deal_time = std::max( _last_deal_time, event.time() );
+
 	updateUserStatistics( event.user(), event.amount(), event.time() );
 }
 
@@ -96,45 +313,144 @@ void EventsHandler::disconnected( const UserDisconnectedEvent& event )
 
 void EventsHandler::addNewUser( const Event::User user, const std::string_view name )
 {
-	_registered_users.emplace( user, name );
-	_statistics.emplace( user, 0 );
-	_sorted_statistics.emplace( 0, user );
+	if ( auto [ span, inserted ] = _registered_users.tryEmplace( user ); inserted ) {
+		span = _names.append( name );
+	}
+	addUser( user );
+}
+
+StringArena::Span EventsHandler::userName( const Event::User user ) const
+{
+	const auto* span = _registered_users.find( user );
+	return span ? *span : StringArena::Span();
 }
 
 Packet EventsHandler::userStatistic( const Event::User user ) const
 {
-	const auto self = userRank( user );
-	const auto position = static_cast< size_t >( std::distance( _sorted_statistics.cbegin(), self ) ) + 1;
+	const auto entry = userEntry( user );
+
+	Packet packet;
+	packet.user = user;
+	packet.position = userRank( entry ) + 1;
+	packet.top = topStatistic();
+	packet.near = neigborsStatistic( entry );
+	if ( _carry_names ) {
+		std::transform( packet.near.cbegin(), packet.near.cend(), packet.near_names.begin(), [this]( const StatisticsEntry& neighbor ) {
+			return userName( neighbor.id );
+		} );
+	}
+	return packet;
+}
 
-	return {user, position, topStatistic(), neigborsStatistic( self, position )};
+std::optional< StatisticsEntry > EventsHandler::userEntry( const Event::User user ) const
+{
+	return userShard( user ).leaderboard.entry( user );
 }
 
-SortedStatistic::const_iterator EventsHandler::userRank( const Event::User user ) const
+size_t EventsHandler::userRank( const std::optional< StatisticsEntry >& entry ) const
 {
-	if ( auto it = _statistics.find( user ); it != _statistics.cend() ) {
-		const auto& [ id, amount ] = *it;
-		return _sorted_statistics.find( {amount, user} );
+	size_t rank = 0;
+	for ( const auto& shard : _shards ) {
+		rank += entry ? shard->leaderboard.rank( *entry ) : shard->leaderboard.size();
 	}
-	return _sorted_statistics.cend();
+	return rank;
 }
 
-SortedStatistic EventsHandler::topStatistic() const
+const TopStatistic& EventsHandler::topStatistic() const
 {
-	const auto& statistics = _sorted_statistics;
-	return SortedStatistic( statistics.cbegin(),
-	                        statistics.size() > neighbors_count ? std::next( statistics.cbegin(), neighbors_count ) : statistics.cend() );
+	if ( !_top_statistic ) {
+		thread_local std::vector< StatisticsEntry > top;
+		top.clear();
+		for ( const auto& shard : _shards ) {
+			const auto& leaderboard = shard->leaderboard;
+			leaderboard.copy( 0, std::min( top_count, leaderboard.size() ), std::back_inserter( top ) );
+		}
+		if ( _shards.size() > 1 ) {
+			std::sort( top.begin(), top.end(), StatisticsComparator() );
+		}
+
+		_top_statistic.emplace();
+		_top_statistic->version = _top_version;
+		_top_statistic->entries.assign( top.cbegin(), std::min( top_count, top.size() ) );
+		if ( _carry_names ) {
+			std::transform( top.cbegin(), top.cbegin() + static_cast< std::ptrdiff_t >( _top_statistic->entries.size() ),
+			                _top_statistic->names.begin(), [this]( const StatisticsEntry& entry ) { return userName( entry.id ); } );
+		}
+	}
+	return *_top_statistic;
 }
 
-SortedStatistic EventsHandler::neigborsStatistic( const SortedStatistic::const_iterator rank, const size_t position ) const
+void EventsHandler::touchTopStatistic( const StatisticsEntry& entry )
 {
-	const auto& statistics = _sorted_statistics;
-	return SortedStatistic( position > neighbors_count ? std::next( rank, -neighbors_count ) : statistics.cbegin(),
-	                        statistics.size() - position > neighbors_count ? std::next( rank, neighbors_count + 1 ) : statistics.cend() );
+	if ( !_top_statistic ) {
+		return;
+	}
+
+	const auto& top = _top_statistic->entries;
+	if ( top.size() < top_count || !StatisticsComparator()( top.back(), entry ) ) {
+		resetTopStatistic();
+	}
 }
 
+void EventsHandler::resetTopStatistic()
+{
+	++_top_version;
+	_top_statistic.reset();
+}
+
+decltype( Packet::near ) EventsHandler::neigborsStatistic( const std::optional< StatisticsEntry >& entry ) const
+{
+	thread_local std::vector< StatisticsEntry > window;
+	window.clear();
+	for ( const auto& shard : _shards ) {
+		const auto& leaderboard = shard->leaderboard;
+		const auto rank = entry ? leaderboard.rank( *entry ) : leaderboard.size();
+		const auto first = rank > neighbors_count ? rank - neighbors_count : 0;
+		const auto last = std::min( rank + neighbors_count + 1, leaderboard.size() );
+		leaderboard.copy( first, last, std::back_inserter( window ) );
+	}
+	if ( _shards.size() > 1 ) {
+		std::sort( window.begin(), window.end(), StatisticsComparator() );
+	}
+
+	const auto self = entry ? std::lower_bound( window.cbegin(), window.cend(), *entry, StatisticsComparator() ) : window.cend();
+	const auto before = std::min( neighbors_count, static_cast< size_t >( self - window.cbegin() ) );
+	const auto after = std::min( neighbors_count + 1, static_cast< size_t >( window.cend() - self ) );
+
+	decltype( Packet::near ) neighbors;
+	neighbors.assign( self - static_cast< std::ptrdiff_t >( before ), before + after );
+	return neighbors;
+}
+
+// Reading the shards needs all of them to have applied what was routed, so with several shards
+// connects are answered together once per drained batch rather than each waiting for every shard.
 void EventsHandler::sendUserStatistics( const Event::User user )
 {
-	sendPacket( userStatistic( user ) );
+	if ( _shards.size() > 1 ) {
+		_pending_connects.push_back( user );
+		if ( _pending_connects.size() >= max_pending_connects ) {
+			flushConnects();
+		}
+		return;
+	}
+	synchronize();
+	sendStatistic( user );
+}
+
+void EventsHandler::flushConnects()
+{
+	if ( !_pending_connects.empty() ) {
+		synchronize();
+	}
+}
+
+void EventsHandler::sendStatistic( const Event::User user )
+{
+	auto packet = userStatistic( user );
+	if ( _view_tracker ) {
+		_view_tracker->sent( packet );
+	}
+	sendPacket( std::move( packet ) );
 }
 
 void EventsHandler::sendPacket( Packet&& packet )
@@ -144,15 +460,33 @@ void EventsHandler::sendPacket( Packet&& packet )
 
 void EventsHandler::addUserAmount( const Event::User user, const int64_t amount )
 {
-	const auto lastAmount = _statistics[ user ];
-	const auto total = lastAmount + amount;
-	_statistics[ user ] = total;
-	if ( auto node = _sorted_statistics.extract( {lastAmount, user} ); !node.empty() ) {
-		node.value().first = total;
-		_sorted_statistics.insert( std::move( node ) );
+	if ( _shards.size() > 1 ) {
+		route( UserDealWonEvent( user, {}, amount ) );
+		return;
 	}
-	else {
-		_sorted_statistics.emplace( total, user );
+
+	auto& leaderboard = _shards.front()->leaderboard;
+	const auto users = leaderboard.size();
+	const auto [ last, current ] = leaderboard.addAmount( user, amount );
+	touchTopStatistic( last );
+	touchTopStatistic( current );
+	if ( _track_changes ) {
+		markChanged( _changed, users != leaderboard.size(), last, current );
+	}
+}
+
+void EventsHandler::addUser( const Event::User user )
+{
+	if ( _shards.size() > 1 ) {
+		route( UserRegisteredEvent( user, {} ) );
+		return;
+	}
+
+	if ( _shards.front()->leaderboard.addUser( user ) ) {
+		touchTopStatistic( {0, user} );
+		if ( _track_changes ) {
+			_changed.markInserted( {0, user} );
+		}
 	}
 }
 
@@ -160,32 +494,56 @@ void EventsHandler::updateUserStatistics( const Event::User user, const int64_t
 {
 	using namespace std::chrono_literals;
 	static const constexpr auto week = 7 * 24h;
+	const auto week_index = time / week;
 	const auto week_time = time % week;
 
-	if ( isNewWeek( week_time ) ) {
+	if ( isPreviousWeek( week_index ) ) {
+		++_previous_week_deals;
+		return;
+	}
+	if ( isNewWeek( week_index ) ) {
 		clearStatistics();
 	}
+	else if ( isLate( week_time ) ) {
+		addUserAmount( user, amount );
+		return;
+	}
 
 	addUserAmount( user, amount );
 
-	if ( isNextMinute( week_time ) ) {
+	if ( !_timed_broadcasts && isNextMinute( week_time ) ) {
 		sendPackets();
 	}
 
-	updateTime( week_time );
+	updateTime( time );
+}
+
+// Weeks are numbered from the epoch, so a deal of an earlier week that arrives after the rollover is
+// told apart from a later deal of the current one however far apart they are in the week.
+bool EventsHandler::isNewWeek( const int64_t week ) const noexcept
+{
+	return _week && week > *_week;
+}
+
+bool EventsHandler::isPreviousWeek( const int64_t week ) const noexcept
+{
+	return _week && week < *_week;
 }
 
-bool EventsHandler::isNewWeek( const std::chrono::nanoseconds time ) const noexcept
+bool EventsHandler::isLate( const std::chrono::nanoseconds time ) const noexcept
 {
 	return last_update_week_time > time;
 }
 
 void EventsHandler::clearStatistics()
 {
-	_sorted_statistics.clear();
-	for ( auto& [ user, amount ] : _statistics ) {
-		amount = 0;
-		_sorted_statistics.emplace( 0, user );
+	synchronize();
+	for ( auto& shard : _shards ) {
+		shard->leaderboard.clear();
+	}
+	resetTopStatistic();
+	if ( _track_changes ) {
+		_changed.markAll();
 	}
 }
 
@@ -197,18 +555,167 @@ bool EventsHandler::isNextMinute( const std::chrono::nanoseconds time ) const no
 
 void EventsHandler::sendPackets()
 {
-	std::vector< Packet > packets;
+	const auto begin = std::chrono::steady_clock::now();
+	synchronize();
+
+	if ( _broadcaster ) {
+		auto broadcast = snapshot();
+		broadcast->changed = takeChanges();
+		_broadcaster->put( std::move( broadcast ) );
+		recordBroadcast( begin );
+		checkpoint();
+		return;
+	}
+
+	auto& packets = _packets;
 
 	const auto& users = _connected_users;
+	packets.clear();
 	packets.reserve( users.size() );
+	if ( !_view_tracker ) {
+		users.forEach( [this, &packets]( const Event::User user ) { packets.push_back( userStatistic( user ) ); } );
+	}
+	else {
+		_view_tracker->startBroadcast( takeChanges(), topStatistic() );
+		users.forEach( [this, &packets]( const Event::User user ) {
+			if ( _view_tracker->needsPacket( user ) ) {
+				_view_tracker->sent( packets.emplace_back( userStatistic( user ) ) );
+			}
+		} );
+		_view_tracker->finishBroadcast( users.size() );
+	}
 
-	const auto transform_operation = [this]( const auto& v ) { return userStatistic( v ); };
-	std::transform( users.cbegin(), users.cend(), std::back_insert_iterator( packets ), transform_operation );
+	_packets_handler.putBroadcast( std::move( packets ) );
+	recordBroadcast( begin );
+	checkpoint();
+}
 
-	_packets_handler.put( std::move( packets ) );
+void EventsHandler::recordBroadcast( const std::chrono::steady_clock::time_point begin )
+{
+	const auto duration = std::chrono::steady_clock::now() - begin;
+	_broadcast_histogram.record( duration );
+	if ( _record_broadcasts ) {
+		_broadcast_times.push_back( {last_update_week_time, duration} );
+	}
+}
+
+DirtyRanges EventsHandler::takeChanges()
+{
+	for ( auto& shard : _shards ) {
+		_changed.append( shard->changed );
+	}
+	return std::move( _changed );
+}
+
+std::unique_ptr< LeaderboardSnapshot > EventsHandler::snapshot() const
+{
+	auto snapshot = std::make_unique< LeaderboardSnapshot >();
+	snapshot->top = topStatistic();
+
+	auto& entries = snapshot->entries;
+	entries.reserve( userRank( std::nullopt ) );
+	for ( const auto& shard : _shards ) {
+		shard->leaderboard.copyUnordered( std::back_inserter( entries ) );
+	}
+
+	if ( _carry_names ) {
+		snapshot->names.reserve( _registered_users.size() );
+		_registered_users.forEach( [&names = snapshot->names]( const Event::User user, const StringArena::Span span ) {
+			names.emplace_back( user, span );
+		} );
+	}
+
+	snapshot->connected.reserve( _connected_users.size() );
+	_connected_users.forEach( [this, &connected = snapshot->connected]( const Event::User user ) {
+		connected.emplace_back( user, userEntry( user ) );
+	} );
+	return snapshot;
 }
 
 void EventsHandler::updateTime( const std::chrono::nanoseconds time ) noexcept
 {
-	last_update_week_time = time;
+	using namespace std::chrono_literals;
+	static const constexpr auto week = 7 * 24h;
+	last_update_week_time = time % week;
+	_week = time / week;
+}
+
+void EventsHandler::restore( const std::string& path )
+{
+	const auto begin = std::chrono::steady_clock::now();
+	const auto file = CheckpointFile::open( path );
+	if ( !file ) {
+		std::cerr << "No checkpoint to restore from " << path << ".\n";
+		return;
+	}
+
+	const auto known = [this]( const Event::User user ) {
+		return 0 == _dense_users || static_cast< uint64_t >( static_cast< uint32_t >( user ) ) < _dense_users;
+	};
+
+	// Shard threads are not started yet, so shards are filled directly. pb_ds trees cannot be built
+	// in bulk, and inserting in key order was measured to be no faster, so entries go in file order.
+	for ( size_t i = 0; i < file->entries(); ++i ) {
+		const auto [ amount, user ] = file->entry( i );
+		if ( !known( user ) ) {
+			continue;
+		}
+		auto& leaderboard = userShard( user ).leaderboard;
+		if ( 0 == amount ) {
+			leaderboard.addUser( user );
+		}
+		else {
+			leaderboard.addAmount( user, amount );
+		}
+	}
+
+	for ( size_t i = 0; i < file->names(); ++i ) {
+		const auto [ user, name ] = file->name( i );
+		if ( known( user ) ) {
+			_registered_users.tryEmplace( user ).first = _names.append( name );
+		}
+	}
+
+	// The restored amounts keep their week, so the first deal of a later week clears them rather
+	// than adding to last week's amounts.
+	_last_deal_time = file->lastDealTime();
+	_checkpoint_time = _last_deal_time;
+	last_update_week_time = file->weekTime();
+	_week = file->week();
+
+	const std::chrono::duration< double, std::milli > time = std::chrono::steady_clock::now() - begin;
+	std::cerr << "restored " << file->entries() << " users and " << file->names() << " names from " << path << " in "
+	          << time.count() << " ms\n";
+}
+
+void EventsHandler::checkpoint()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if ( !_checkpoint_writer || now - _last_checkpoint < _checkpoint_period || _checkpoint_writer->writing() ) {
+		return;
+	}
+
+	_checkpoint_writer->put( checkpointState() );
+	_last_checkpoint = now;
+}
+
+std::unique_ptr< CheckpointState > EventsHandler::checkpointState()
+{
+	synchronize();
+
+	auto state = std::make_unique< CheckpointState >();
+	state->entries.reserve( userRank( std::nullopt ) );
+	for ( const auto& shard : _shards ) {
+		shard->leaderboard.copyUnordered( std::back_inserter( state->entries ) );
+	}
+
+	state->names.reserve( _registered_users.size() );
+	_registered_users.forEach( [&names = state->names]( const Event::User user, const StringArena::Span span ) {
+		names.emplace_back( user, span );
+	} );
+
+	state->last_deal_time = _last_deal_time;
+	state->week_time = last_update_week_time;
+	state->week = _week;
+	return state;
 }
@@ -1,35 +1,117 @@
 #pragma once
 
+#include <array>
 #include <atomic>
-#include <condition_variable>
-#include <deque>
+#include <chrono>
 #include <memory>
-#include <mutex>
+#include <optional>
+#include <string>
 #include <string_view>
-#include <unordered_map>
-#include <unordered_set>
+#include <thread>
 #include <vector>
 
 #include <libs/event.h>
-
+#include <libs/spsc_queue.h>
+#include <libs/string_arena.h>
+
+#include "broadcaster.h"
+#include "checkpoint.h"
+#include "leaderboard.h"
+#include "leaderboard_snapshot.h"
+#include "metrics.h"
 #include "packets_handler.h"
 #include "statistics.h"
+#include "users.h"
+#include "view_tracker.h"
+
+struct EventsHandlerConfig
+{
+	size_t queue_capacity = 64 * 1024;
+	size_t inputs = 1;
+	size_t workers = 1;
+	size_t broadcast_threads = 0;
+	// Minute broadcasts are started by broadcast() instead of by deal times crossing a minute.
+	bool timed_broadcasts = false;
+	// When not zero, broadcasts leave out users whose view did not change, unless they have not been
+	// sent a packet for max_silence broadcasts.
+	size_t max_silence = 0;
+	// Packets carry the names of their top and near entries.
+	bool names = false;
+	// When not zero, user ids are taken to lie in [0, dense_users) and index per-user arrays instead
+	// of hash maps, with a single worker; events of other users are ignored.
+	size_t dense_users = 0;
+	// When not empty, the state is restored from this checkpoint file on start, checkpointed to it
+	// in the background at most every checkpoint_period and once more on shutdown.
+	// Restoring inserts every user into the order-statistic trees one by one, O(n log n): 1 to 3 s
+	// per million users with amounts, so it is no sub-second start for large user counts.
+	std::string checkpoint_path;
+	std::chrono::seconds checkpoint_period{60};
+	// Keeps the duration of every minute broadcast for broadcastTimes().
+	bool record_broadcasts = false;
+};
+
+struct BroadcastTime
+{
+	// Week time of the last deal before the broadcast.
+	std::chrono::nanoseconds week_time;
+	std::chrono::nanoseconds duration;
+};
 
 class EventsHandler
 {
 public:
-	EventsHandler( PacketsHandler& packetsHandler );
+	EventsHandler( PacketsHandler& packetsHandler, const EventsHandlerConfig& config = {} );
+	~EventsHandler();
 
-	void put( std::unique_ptr< Event >&& event );
+	// Each input is fed by its own producer thread.
+	void put( const Event& event, const size_t input = 0 );
 
 	void procesing();
 
 	void stopProcessing();
 
-private:
-	static constexpr int neighbors_count = 10;
+	void handle( const Event& event );
 
-	bool pop();
+	// With several shards handle() answers connects in batches; sends the statistics of connects
+	// still waiting. procesing() and broadcasts call it on their own.
+	void flushConnects();
+
+	void broadcast();
+
+	const std::vector< BroadcastTime >& broadcastTimes() const noexcept;
+
+	// Queued events, handled events by type, names lost to a full names arena and the time to drain
+	// a batch and to broadcast; safe to call from any thread.
+	void writeMetrics( MetricsWriter& writer ) const;
+
+private:
+	static constexpr size_t top_count = TopStatistic::capacity;
+	static constexpr size_t max_pending_connects = 256;
+	static constexpr size_t neighbors_count = Packet::neighbors_count;
+
+	// Users are partitioned between shards; with more than one shard every shard is updated by
+	// its own worker thread while queries are answered by merging the shards.
+	struct Shard
+	{
+		Shard( const size_t queue_capacity, const bool track_changes, const size_t dense_users );
+
+		Leaderboard leaderboard;
+		const bool track_changes;
+		DirtyRanges changed;
+		SpscQueue< Event > events;
+		std::atomic< uint64_t > applied{0};
+		uint64_t routed = 0;
+		std::thread thread;
+	};
+
+	void shardProcessing( Shard& shard );
+	static void apply( Shard& shard, const Event& event );
+	static void markChanged( DirtyRanges& changed, const bool inserted, const StatisticsEntry& last, const StatisticsEntry& current );
+
+	Shard& userShard( const Event::User user ) noexcept;
+	const Shard& userShard( const Event::User user ) const noexcept;
+	void route( const Event& event );
+	void synchronize();
 
 	void registered( const UserRegisteredEvent& event );
 	void connected( const UserConnectedEvent& event );
@@ -38,45 +120,89 @@ private:
 	void disconnected( const UserDisconnectedEvent& event );
 
 	void addNewUser( const Event::User user, const std::string_view name );
+	StringArena::Span userName( const Event::User user ) const;
 
 	void sendUserStatistics( const Event::User user );
+	void sendStatistic( const Event::User user );
 
 	Packet userStatistic( const Event::User user ) const;
 
-	SortedStatistic::const_iterator userRank( const Event::User user ) const;
+	std::optional< StatisticsEntry > userEntry( const Event::User user ) const;
+	size_t userRank( const std::optional< StatisticsEntry >& entry ) const;
 
-	SortedStatistic topStatistic() const;
-	SortedStatistic neigborsStatistic( const SortedStatistic::const_iterator rank, const size_t position ) const;
+	const TopStatistic& topStatistic() const;
+	void touchTopStatistic( const StatisticsEntry& entry );
+	void resetTopStatistic();
+	decltype( Packet::near ) neigborsStatistic( const std::optional< StatisticsEntry >& entry ) const;
 
 	void sendPacket( Packet&& packet );
 
 	void updateUserStatistics( const Event::User user, const int64_t amount, const std::chrono::nanoseconds time );
 
-	bool isNewWeek( const std::chrono::nanoseconds time ) const noexcept;
+	bool isNewWeek( const int64_t week ) const noexcept;
+	bool isPreviousWeek( const int64_t week ) const noexcept;
+	bool isLate( const std::chrono::nanoseconds time ) const noexcept;
 
 	void clearStatistics();
 
 	bool isNextMinute( const std::chrono::nanoseconds time ) const noexcept;
 
 	void addUserAmount( const Event::User user, const int64_t amount );
+	void addUser( const Event::User user );
 
 	void sendPackets();
+	void recordBroadcast( const std::chrono::steady_clock::time_point begin );
+	DirtyRanges takeChanges();
+	std::unique_ptr< LeaderboardSnapshot > snapshot() const;
 
 	void updateTime( const std::chrono::nanoseconds time ) noexcept;
 
-	std::atomic< bool > _stopped;
-	std::mutex _mutex;
-	std::condition_variable _condition_variable;
+	void restore( const std::string& path );
+	void checkpoint();
+	std::unique_ptr< CheckpointState > checkpointState();
+
+	Doorbell _events_doorbell;
+	std::vector< std::unique_ptr< SpscQueue< Event > > > _unhandled_events;
+
+	const size_t _dense_users;
+	uint64_t _ignored_events = 0;
+
+	StringArena _names;
+	UserMap< StringArena::Span > _registered_users;
+	const bool _carry_names;
 
-	std::deque< std::unique_ptr< Event > > _unhandled_events;
-	std::vector< std::unique_ptr< Event > > _processing_events;
+	std::chrono::nanoseconds last_update_week_time{};
+	// Week of the latest deal counted from the epoch; until the first deal any week is the current one.
+	std::optional< int64_t > _week;
+	uint64_t _previous_week_deals = 0;
+	UserSet _connected_users;
+	std::vector< Event::User > _pending_connects;
+	std::vector< Packet > _packets;
+	std::vector< std::unique_ptr< Shard > > _shards;
 
-	std::unordered_map< Event::User, std::string > _registered_users;
+	const bool _track_changes;
+	DirtyRanges _changed;
+	std::unique_ptr< ViewTracker > _view_tracker;
 
-	std::chrono::nanoseconds last_update_week_time;
-	std::unordered_set< Event::User > _connected_users;
-	Statistics _statistics;
-	SortedStatistic _sorted_statistics;
+	bool _top_dirty = false;
+	uint64_t _top_version = 0;
+	mutable std::optional< TopStatistic > _top_statistic;
 
 	PacketsHandler& _packets_handler;
+	std::unique_ptr< Broadcaster > _broadcaster;
+	const bool _timed_broadcasts;
+	const bool _record_broadcasts;
+	std::vector< BroadcastTime > _broadcast_times;
+
+	std::array< Counter, static_cast< size_t >( Event::Type::user_disconnected ) + 1 > _handled_events;
+	StageTimer _drain_timer;
+	LatencyHistogram _broadcast_histogram;
+
+	std::unique_ptr< CheckpointWriter > _checkpoint_writer;
+	const std::chrono::seconds _checkpoint_period;
+	std::chrono::steady_clock::time_point _last_checkpoint;
+	std::chrono::nanoseconds _last_deal_time{};
+	// Deals up to this time are already in the restored checkpoint and are skipped.
+	std::optional< std::chrono::nanoseconds > _checkpoint_time;
+	uint64_t _replayed_deals = 0;
 };
@@ -0,0 +1,181 @@
+#include "leaderboard.h"
+
+#include <limits>
+
+namespace
+{
+constexpr size_t released_per_update = 2;
+
+template < typename Tree >
+void releaseNodes( std::deque< Tree >& trees, size_t count )
+{
+	while ( count > 0 && !trees.empty() ) {
+		auto& tree = trees.front();
+		for ( ; count > 0 && !tree.empty(); --count ) {
+			tree.erase( tree.begin() );
+		}
+		if ( tree.empty() ) {
+			trees.pop_front();
+		}
+	}
+}
+}
+
+Leaderboard::Leaderboard( const size_t dense_users ) : _dense( dense_users > 0 ), _known_users( dense_users )
+{
+}
+
+bool Leaderboard::addUser( const Event::User user )
+{
+	releaseRetired();
+	const auto users = size();
+	weeklyAmount( user );
+	return size() != users;
+}
+
+std::pair< StatisticsEntry, StatisticsEntry > Leaderboard::addAmount( const Event::User user, const int64_t amount )
+{
+	releaseRetired();
+
+	auto [ total, week ] = weeklyAmount( user );
+	if ( week != _week ) {
+		total = 0;
+		week = _week;
+	}
+
+	const StatisticsEntry last{total, user};
+	total += amount;
+	const StatisticsEntry current{total, user};
+
+	if ( 0 != last.amount ) {
+		_sorted_statistics.erase( last );
+	}
+	if ( 0 != current.amount ) {
+		_sorted_statistics.insert( current );
+	}
+	if ( ( 0 == last.amount ) != ( 0 == current.amount ) ) {
+		if ( 0 == current.amount ) {
+			_sorted_users.erase( user );
+		}
+		else {
+			_sorted_users.insert( user );
+		}
+	}
+	return {last, current};
+}
+
+void Leaderboard::clear()
+{
+	if ( !_sorted_statistics.empty() ) {
+		_retired_statistics.emplace_back().swap( _sorted_statistics );
+	}
+	if ( !_sorted_users.empty() ) {
+		_retired_users.emplace_back().swap( _sorted_users );
+	}
+	++_week;
+}
+
+size_t Leaderboard::size() const noexcept
+{
+	return _dense ? _known_users.size() : _users.size();
+}
+
+std::optional< StatisticsEntry > Leaderboard::entry( const Event::User user ) const
+{
+	if ( _dense ) {
+		if ( !_known_users.contains( static_cast< size_t >( user ) ) ) {
+			return std::nullopt;
+		}
+		return StatisticsEntry{amount( user ), user};
+	}
+	if ( auto it = _statistics.find( user ); it != _statistics.cend() ) {
+		return StatisticsEntry{it->second.week == _week ? it->second.amount : 0, user};
+	}
+	return std::nullopt;
+}
+
+size_t Leaderboard::rank( const StatisticsEntry& entry ) const
+{
+	const auto active = _sorted_statistics.order_of_key( entry );
+	if ( entry.amount > 0 ) {
+		return active;
+	}
+	if ( entry.amount < 0 ) {
+		return active + size() - _sorted_statistics.size();
+	}
+	return active + usersBefore( entry.id ) - _sorted_users.order_of_key( entry.id );
+}
+
+std::pair< int64_t&, uint32_t& > Leaderboard::weeklyAmount( const Event::User user )
+{
+	if ( _dense ) {
+		const auto index = static_cast< size_t >( user );
+		if ( _known_users.insert( index ) ) {
+			if ( index >= _amounts.size() ) {
+				_amounts.resize( index + 1 );
+				_weeks.resize( index + 1 );
+			}
+			_amounts[ index ] = 0;
+			_weeks[ index ] = _week;
+		}
+		return {_amounts[ index ], _weeks[ index ]};
+	}
+
+	auto [ it, inserted ] = _statistics.emplace( user, WeeklyAmount{0, _week} );
+	if ( inserted ) {
+		_users.insert( user );
+	}
+	return {it->second.amount, it->second.week};
+}
+
+int64_t Leaderboard::amount( const Event::User user ) const
+{
+	if ( _dense ) {
+		const auto index = static_cast< size_t >( user );
+		return _known_users.contains( index ) && _weeks[ index ] == _week ? _amounts[ index ] : 0;
+	}
+	const auto it = _statistics.find( user );
+	return it != _statistics.cend() && it->second.week == _week ? it->second.amount : 0;
+}
+
+size_t Leaderboard::positiveCount() const
+{
+	return _sorted_statistics.order_of_key( {0, std::numeric_limits< Event::User >::min()} );
+}
+
+size_t Leaderboard::usersBefore( const Event::User user ) const
+{
+	if ( _dense ) {
+		return user < 0 ? 0 : _known_users.rank( static_cast< size_t >( user ) );
+	}
+	return _users.order_of_key( user );
+}
+
+Event::User Leaderboard::userAt( const size_t position ) const
+{
+	return _dense ? static_cast< Event::User >( _known_users.select( position ) ) : *_users.find_by_order( position );
+}
+
+size_t Leaderboard::zeroPosition( const size_t index ) const
+{
+	size_t first = index;
+	size_t last = std::min( index + _sorted_users.size(), size() - 1 );
+	while ( first < last ) {
+		const auto middle = first + ( last - first ) / 2;
+		const auto user = userAt( middle );
+		const auto zeros = middle + 1 - _sorted_users.order_of_key( user ) - ( 0 != amount( user ) ? 1 : 0 );
+		if ( zeros > index ) {
+			last = middle;
+		}
+		else {
+			first = middle + 1;
+		}
+	}
+	return first;
+}
+
+void Leaderboard::releaseRetired()
+{
+	releaseNodes( _retired_statistics, released_per_update );
+	releaseNodes( _retired_users, released_per_update );
+}
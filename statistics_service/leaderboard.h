@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <libs/event.h>
+#include <libs/rank_bitmap.h>
+
+#include "statistics.h"
+
+// Weekly amounts of a set of users together with their order-statistic index.
+// Only users with a nonzero amount this week are kept in the sorted index; all other users rank
+// at zero by id. clear() starts a new week in O(1): the previous index is retired and freed a few
+// nodes at a time by later updates, oldest week first, and amounts of earlier weeks read as zero.
+// With dense_users, user ids must lie in [0, dense_users): they index plain arrays of amounts and
+// weeks, and a RankBitmap replaces the hash map and the tree of all users.
+class Leaderboard
+{
+public:
+	explicit Leaderboard( const size_t dense_users = 0 );
+
+	bool addUser( const Event::User user );
+
+	// Returns the user's entry before and after the update.
+	std::pair< StatisticsEntry, StatisticsEntry > addAmount( const Event::User user, const int64_t amount );
+
+	void clear();
+
+	size_t size() const noexcept;
+
+	std::optional< StatisticsEntry > entry( const Event::User user ) const;
+
+	// Number of entries ordered before the given one, whether or not it is present.
+	size_t rank( const StatisticsEntry& entry ) const;
+
+	template < typename OutputIterator >
+	OutputIterator copy( size_t first, const size_t last, OutputIterator out ) const
+	{
+		const auto positive = positiveCount();
+		const auto zero = size() - _sorted_statistics.size();
+
+		if ( first < std::min( last, positive ) ) {
+			const auto count = std::min( last, positive ) - first;
+			out = std::copy_n( _sorted_statistics.find_by_order( first ), count, out );
+			first += count;
+		}
+
+		// Users with an amount are skipped by searching for the next zero position rather than one id
+		// at a time, so that the walk does not depend on how many users are active.
+		const auto zero_last = std::min( last, positive + zero );
+		while ( first < zero_last ) {
+			forUsersFrom( zeroPosition( first - positive ), [&]( const Event::User user ) {
+				if ( 0 != amount( user ) ) {
+					return false;
+				}
+				*out++ = StatisticsEntry{0, user};
+				return ++first < zero_last;
+			} );
+		}
+
+		if ( first < last ) {
+			out = std::copy_n( _sorted_statistics.find_by_order( first - zero ), last - first, out );
+		}
+		return out;
+	}
+
+	// Copies all entries in no particular order, without walking the tree.
+	template < typename OutputIterator >
+	OutputIterator copyUnordered( OutputIterator out ) const
+	{
+		if ( _dense ) {
+			_known_users.forEach( [this, &out]( const size_t user ) {
+				*out++ = StatisticsEntry{_weeks[ user ] == _week ? _amounts[ user ] : 0, static_cast< Event::User >( user )};
+			} );
+			return out;
+		}
+		for ( const auto& [ user, amount ] : _statistics ) {
+			*out++ = StatisticsEntry{amount.week == _week ? amount.amount : 0, user};
+		}
+		return out;
+	}
+
+private:
+	// Amount and week of the user, added with a zero amount when unknown.
+	std::pair< int64_t&, uint32_t& > weeklyAmount( const Event::User user );
+	int64_t amount( const Event::User user ) const;
+
+	// Number of known users with a smaller id, and the user at the given position by id.
+	size_t usersBefore( const Event::User user ) const;
+	Event::User userAt( const size_t position ) const;
+
+	// Calls function( user ) for the users from the given position by id on while it returns true.
+	template < typename Function >
+	void forUsersFrom( const size_t position, Function&& function ) const
+	{
+		if ( _dense ) {
+			for ( auto user = _known_users.select( position ); user < _known_users.capacity(); user = _known_users.next( user + 1 ) ) {
+				if ( !function( static_cast< Event::User >( user ) ) ) {
+					return;
+				}
+			}
+			return;
+		}
+		for ( auto it = _users.find_by_order( position ); it != _users.end() && function( *it ); ++it ) {
+		}
+	}
+
+	size_t positiveCount() const;
+
+	// Position in _users of the index-th user with no amount this week.
+	size_t zeroPosition( const size_t index ) const;
+
+	void releaseRetired();
+
+	uint32_t _week = 0;
+	Statistics _statistics;
+	SortedUsers _users;
+
+	const bool _dense;
+	RankBitmap _known_users;
+	std::vector< int64_t > _amounts;
+	std::vector< uint32_t > _weeks;
+
+	SortedStatistic _sorted_statistics;
+	SortedUsers _sorted_users;
+
+	// Indexes of earlier weeks, oldest first.
+	std::deque< SortedStatistic > _retired_statistics;
+	std::deque< SortedUsers > _retired_users;
+};
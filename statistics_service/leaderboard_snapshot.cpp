@@ -0,0 +1,52 @@
+#include "leaderboard_snapshot.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <libs/radix_sort.h>
+
+void LeaderboardSnapshot::rank( ThreadPool& pool )
+{
+	radixSort( pool, entries, StatisticsKey(), StatisticsKey::bytes );
+	radixSort( pool, names, []( const auto& name ) { return static_cast< uint32_t >( name.first ) ^ ( uint32_t( 1 ) << 31 ); }, sizeof( Event::User ) );
+
+	std::vector< size_t > order( connected.size() );
+	std::iota( order.begin(), order.end(), 0 );
+	order.erase( std::remove_if( order.begin(), order.end(), [this]( const size_t i ) { return !connected[ i ].second; } ),
+	             order.end() );
+	std::sort( order.begin(), order.end(), [this]( const size_t lhs, const size_t rhs ) {
+		return StatisticsComparator()( *connected[ lhs ].second, *connected[ rhs ].second );
+	} );
+
+	ranks.assign( connected.size(), entries.size() );
+	size_t rank = 0;
+	for ( const auto i : order ) {
+		const auto& entry = *connected[ i ].second;
+		while ( rank < entries.size() && StatisticsComparator()( entries[ rank ], entry ) ) {
+			++rank;
+		}
+		ranks[ i ] = rank;
+	}
+}
+
+Packet LeaderboardSnapshot::packet( const size_t index ) const
+{
+	const auto rank = ranks[ index ];
+	const auto first = rank > Packet::neighbors_count ? rank - Packet::neighbors_count : 0;
+	const auto last = std::min( rank + Packet::neighbors_count + 1, entries.size() );
+
+	Packet packet;
+	packet.user = connected[ index ].first;
+	packet.position = rank + 1;
+	packet.top = top;
+	packet.near.assign( entries.cbegin() + static_cast< std::ptrdiff_t >( first ), last - first );
+	if ( !names.empty() ) {
+		std::transform( packet.near.cbegin(), packet.near.cend(), packet.near_names.begin(), [this]( const StatisticsEntry& entry ) {
+			const auto it = std::lower_bound( names.cbegin(), names.cend(), entry.id, []( const auto& name, const Event::User user ) {
+				return name.first < user;
+			} );
+			return it != names.cend() && it->first == entry.id ? it->second : StringArena::Span();
+		} );
+	}
+	return packet;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <libs/event.h>
+#include <libs/string_arena.h>
+#include <libs/thread_pool.h>
+
+#include "packets_handler.h"
+#include "statistics.h"
+#include "view_tracker.h"
+
+// Leaderboard frozen at a minute boundary together with the users connected at that moment,
+// so that the minute broadcast can be built while new deals are being applied.
+struct LeaderboardSnapshot
+{
+	using ConnectedUser = std::pair< Event::User, std::optional< StatisticsEntry > >;
+
+	TopStatistic top;
+	std::vector< StatisticsEntry > entries;
+	std::vector< ConnectedUser > connected;
+	std::vector< size_t > ranks;
+	// Changes since the previous snapshot, when views are tracked.
+	DirtyRanges changed;
+	// Names of all users when packets carry names; sorted by user in rank().
+	std::vector< std::pair< Event::User, StringArena::Span > > names;
+
+	// Flattens the entries into rank order and resolves the rank of every connected user in one sweep.
+	void rank( ThreadPool& pool );
+
+	// Slice of the ranked entries around the index-th connected user.
+	Packet packet( const size_t index ) const;
+};
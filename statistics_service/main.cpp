@@ -1,56 +1,148 @@
-#include <functional>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <signal.h>
 #include <unistd.h>
 
-#include <libs/common.h>
 #include <libs/event.h>
+#include <libs/options.h>
 
 #include "events_handler.h"
 #include "packets_handler.h"
+#include "reactor.h"
+#include "receiver.h"
+#include "replay.h"
+#include "stats_server.h"
 
 static std::atomic< bool > stopped( false );
 
-void receive_loop( const uint16_t receive_port, std::function< void( std::unique_ptr< Event >&& event ) > put_event )
+// Metrics of the given receivers and of both handlers, when a stats port or log period is set.
+static std::unique_ptr< StatsServer > createStatsServer( const Options& options,
+                                                         const std::vector< std::unique_ptr< Receiver > >& receivers,
+                                                         const EventsHandler& events_handler,
+                                                         const PacketsHandler& packets_handler )
 {
-	const auto socket_fd = createSocket();
-	bindSocket( socket_fd, receive_port );
-
-	constexpr size_t buffer_length = 1024;
-	std::string buffer( buffer_length, '\0' );
-	while ( !stopped.load() ) {
-		if ( auto readBytes = recv( socket_fd, buffer.data(), buffer.size(), 0 ); readBytes <= 0 ) {
-			continue;
-		}
+	const auto port = static_cast< uint16_t >( options.number( "stats-port", 0 ) );
+	const std::chrono::seconds period( options.number( "stats-period", 0 ) );
+	if ( 0 == port && 0 == period.count() ) {
+		return nullptr;
+	}
 
-		std::istringstream ss( buffer );
+	return std::make_unique< StatsServer >( port, period, [&]( MetricsWriter& writer ) {
+		for ( size_t i = 0; i < receivers.size(); ++i ) {
+			receivers[ i ]->writeMetrics( writer, "receiver." + std::to_string( i ) );
+		}
+		events_handler.writeMetrics( writer );
+		packets_handler.writeMetrics( writer );
+	} );
+}
 
-		BaseEvent base_event;
-		ss >> base_event;
+static int runReplay( const std::string& path, EventsHandler& events_handler, PacketsHandler& packets_handler )
+{
+	Replay replay( path );
+	if ( !replay.isOpen() ) {
+		std::cerr << "Cannot open file " << path << ".\n";
+		return -1;
+	}
 
-		if ( auto event = Event::createEvent( base_event ); event ) {
-			ss >> *event;
-			put_event( std::move( event ) );
-		}
+	const auto begin = std::chrono::steady_clock::now();
+	const auto events = replay.run( events_handler, packets_handler, stopped );
+	const std::chrono::duration< double > time = std::chrono::steady_clock::now() - begin;
+
+	using milliseconds = std::chrono::duration< double, std::milli >;
+	milliseconds total{};
+	milliseconds longest{};
+	for ( const auto& [ week_time, duration ] : events_handler.broadcastTimes() ) {
+		std::cout << "broadcast at minute " << std::chrono::duration_cast< std::chrono::minutes >( week_time ).count() << ": "
+		          << milliseconds( duration ).count() << " ms\n";
+		total += duration;
+		longest = std::max< milliseconds >( longest, duration );
 	}
-	close( socket_fd );
+
+	const auto broadcasts = events_handler.broadcastTimes().size();
+	std::cerr << "replayed " << events << " events in " << time.count() << " s, " << static_cast< double >( events ) / time.count()
+	          << " events/s, skipped " << replay.skipped() << " malformed lines\n";
+	std::cerr << "broadcasts: " << broadcasts << ", total " << total.count() << " ms, average "
+	          << ( broadcasts > 0 ? total.count() / static_cast< double >( broadcasts ) : 0.0 ) << " ms, longest " << longest.count()
+	          << " ms\n";
+	return 0;
 }
 
 int main( int argc, char* argv[] )
 {
-	if ( argc < 4 ) {
+	const Options options( argc, argv );
+	const auto& arguments = options.positional();
+	if ( arguments.size() < 3 ) {
 		return -1;
 	}
 
-	const uint16_t receive_port = static_cast< uint16_t >( std::stoul( argv[ 1 ] ) );
-	const char* send_address = argv[ 2 ];
-	const uint16_t send_port = static_cast< uint16_t >( std::stoul( argv[ 3 ] ) );
+	const uint16_t receive_port = static_cast< uint16_t >( std::stoul( std::string( arguments[ 0 ] ) ) );
+	const std::string send_address( arguments[ 1 ] );
+	const uint16_t send_port = static_cast< uint16_t >( std::stoul( std::string( arguments[ 2 ] ) ) );
+	// One encoding for all receivers: they share the receive port, and the kernel rather than the
+	// sender decides which of them gets a datagram.
+	const bool binary = "binary" == options.value( "protocol", "text" );
+	const size_t batch_size = std::max< size_t >( 1, options.number( "batch", 1 ) );
+	const bool reactor = "reactor" == options.value( "mode", "threads" );
+	const size_t receivers_count = reactor ? 1 : std::max< size_t >( 1, options.number( "receivers", 1 ) );
+	const bool io_uring = "uring" == options.value( "io", "socket" );
+	const std::string replay_path( options.value( "replay" ) );
+	const bool replay = !replay_path.empty();
+
+	PacketsHandlerConfig packets_config;
+	packets_config.batch_size = batch_size;
+	packets_config.queue_capacity = options.number( "packets-queue", packets_config.queue_capacity );
+	packets_config.outbox_capacity = options.number( "outbox", packets_config.outbox_capacity );
+	packets_config.io_uring = io_uring;
+	packets_config.binary = "binary" == options.value( "packet-format", "text" );
+	packets_config.direct = reactor || replay;
+	packets_config.keyframe_interval = options.number( "delta-keyframe", packets_config.keyframe_interval );
+
+	EventsHandlerConfig events_config;
+	events_config.queue_capacity = options.number( "events-queue", events_config.queue_capacity );
+	events_config.inputs = receivers_count;
+	events_config.workers = reactor ? 1 : options.number( "workers", events_config.workers );
+	events_config.broadcast_threads = reactor || replay ? 0 : options.number( "broadcast-threads", events_config.broadcast_threads );
+	events_config.timed_broadcasts = reactor;
+	events_config.max_silence = options.number( "max-silence", events_config.max_silence );
+	events_config.names = options.has( "names" );
+	events_config.dense_users = options.number( "dense-users", events_config.dense_users );
+	events_config.checkpoint_path = options.value( "checkpoint" );
+	events_config.checkpoint_period = std::chrono::seconds( options.number( "checkpoint-period", events_config.checkpoint_period.count() ) );
+	events_config.record_broadcasts = replay;
+
+	static PacketsHandler packets_handler( send_address, send_port, packets_config );
+	static EventsHandler events_handler( packets_handler, events_config );
+
+	std::vector< std::unique_ptr< Receiver > > receivers;
+	if ( replay ) {
+		const auto stats_server = createStatsServer( options, receivers, events_handler, packets_handler );
+		signal( SIGINT, []( int ) { stopped.store( true ); } );
+		return runReplay( replay_path, events_handler, packets_handler );
+	}
 
-	static PacketsHandler packets_handler( send_address, send_port );
-	static EventsHandler events_handler( packets_handler );
-	auto put_event = []( std::unique_ptr< Event >&& event ) { events_handler.put( std::move( event ) ); };
+	for ( size_t i = 0; i < receivers_count; ++i ) {
+		receivers.push_back( std::make_unique< Receiver >( receive_port, binary, batch_size, io_uring && !reactor, receivers_count > 1 ) );
+	}
+	// Only binary events carry the user at a fixed offset for the kernel to steer by.
+	if ( receivers_count > 1 && !receivers.front()->steerByUser( receivers_count ) ) {
+		std::cerr << ( binary ? "Steering by user is not available" : "Text events cannot be steered by user" )
+		          << ", events of one user may be reordered between receivers.\n";
+	}
+	const auto stats_server = createStatsServer( options, receivers, events_handler, packets_handler );
+
+	const auto print_receivers = [&receivers] {
+		for ( const auto& receiver : receivers ) {
+			std::cerr << "received " << receiver->datagrams() << " datagrams in " << receiver->calls() << " calls"
+			          << ( receiver->usesIoUring() ? " with io_uring" : "" ) << "\n";
+		}
+	};
 
 	auto stop_tasks = []( int ) {
 		stopped.store( true );
@@ -60,12 +152,32 @@ int main( int argc, char* argv[] )
 
 	signal( SIGINT, stop_tasks );
 
+	if ( reactor ) {
+		const std::chrono::milliseconds broadcast_period( options.number( "broadcast-period", 60000 ) );
+		Reactor reactor_loop( events_handler, packets_handler, *receivers.front(), broadcast_period );
+		if ( !reactor_loop.isOpen() ) {
+			return -1;
+		}
+		reactor_loop.run( stopped );
+		packets_handler.flush();
+		print_receivers();
+		return 0;
+	}
+
 	std::thread events_thread( [] { events_handler.procesing(); } );
 	std::thread packets_thread( [] { packets_handler.proccesing(); } );
 
-	std::thread receive_thread( std::bind( receive_loop, receive_port, put_event ) );
+	std::vector< std::thread > receive_threads;
+	for ( size_t i = 0; i < receivers_count; ++i ) {
+		receive_threads.emplace_back( [&receiver = *receivers[ i ], i] {
+			receiver.run( stopped, [i]( const Event& event ) { events_handler.put( event, i ); } );
+		} );
+	}
 
-	receive_thread.join();
+	for ( auto& thread : receive_threads ) {
+		thread.join();
+	}
+	print_receivers();
 	events_thread.join();
 	packets_thread.join();
 
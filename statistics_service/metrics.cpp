@@ -0,0 +1,34 @@
+#include "metrics.h"
+
+#include <ostream>
+
+void MetricsWriter::begin( std::ostream& out )
+{
+	const auto now = std::chrono::steady_clock::now();
+	_out = &out;
+	_elapsed = std::chrono::duration< double >( now - _last ).count();
+	_last = now;
+}
+
+void MetricsWriter::gauge( const std::string_view name, const uint64_t value )
+{
+	*_out << name << " " << value << "\n";
+}
+
+void MetricsWriter::counter( const std::string_view name, const uint64_t value )
+{
+	auto& previous = _previous[ std::string( name ) ];
+	const auto rate = _elapsed > 0 ? static_cast< double >( value - previous ) / _elapsed : 0.0;
+	previous = value;
+	*_out << name << " " << value << "\n" << name << ".per_sec " << rate << "\n";
+}
+
+void MetricsWriter::histogram( const std::string_view name, const LatencyHistogram& histogram )
+{
+	using microseconds = std::chrono::duration< double, std::micro >;
+	*_out << name << ".count " << histogram.count() << "\n"
+	      << name << ".p50_us " << microseconds( histogram.percentile( 0.5 ) ).count() << "\n"
+	      << name << ".p99_us " << microseconds( histogram.percentile( 0.99 ) ).count() << "\n"
+	      << name << ".p999_us " << microseconds( histogram.percentile( 0.999 ) ).count() << "\n"
+	      << name << ".max_us " << microseconds( histogram.max() ).count() << "\n";
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <libs/latency_histogram.h>
+
+// Counter written by one thread and read by any: a relaxed load and store instead of a locked add.
+class Counter
+{
+public:
+	void add( const uint64_t value = 1 ) noexcept
+	{
+		_value.store( _value.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+	}
+
+	uint64_t load() const noexcept
+	{
+		return _value.load( std::memory_order_relaxed );
+	}
+
+private:
+	std::atomic< uint64_t > _value{0};
+};
+
+// Value set by one thread and read by any.
+class Gauge
+{
+public:
+	void set( const uint64_t value ) noexcept
+	{
+		_value.store( value, std::memory_order_relaxed );
+	}
+
+	uint64_t load() const noexcept
+	{
+		return _value.load( std::memory_order_relaxed );
+	}
+
+private:
+	std::atomic< uint64_t > _value{0};
+};
+
+// Times one call in every sample_period into a histogram, so that hot loops do not read the
+// clock on every pass.
+class StageTimer
+{
+public:
+	static constexpr uint64_t sample_period = 16;
+
+	template < typename Function >
+	void measure( Function&& function )
+	{
+		if ( ++_calls % sample_period != 0 ) {
+			function();
+			return;
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		function();
+		_histogram.record( std::chrono::steady_clock::now() - begin );
+	}
+
+	const LatencyHistogram& histogram() const noexcept
+	{
+		return _histogram;
+	}
+
+private:
+	uint64_t _calls = 0;
+	LatencyHistogram _histogram;
+};
+
+// Writes metrics as "<name> <value>" lines. Counters are followed by their rate since the previous
+// dump of the same writer, so one writer serves one reader thread.
+class MetricsWriter
+{
+public:
+	void begin( std::ostream& out );
+
+	void gauge( const std::string_view name, const uint64_t value );
+	void counter( const std::string_view name, const uint64_t value );
+	// Count, then p50, p99, p999 and max in microseconds.
+	void histogram( const std::string_view name, const LatencyHistogram& histogram );
+
+private:
+	std::ostream* _out = nullptr;
+	std::chrono::steady_clock::time_point _last = std::chrono::steady_clock::now();
+	double _elapsed = 0;
+	std::unordered_map< std::string, uint64_t > _previous;
+};
@@ -1,86 +1,645 @@
 #include "packets_handler.h"
 
 #include <algorithm>
-#include <cstring>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <iostream>
 #include <ostream>
-#include <sstream>
+#include <type_traits>
 
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <libs/common.h>
+#include <libs/little_endian.h>
 
-std::ostream& operator<<( std::ostream& out, const Packet& packet )
+namespace
+{
+class TextWriter
+{
+public:
+	TextWriter( char* buffer, const size_t size ) : _begin( buffer ), _position( buffer ), _end( buffer + size )
+	{
+	}
+
+	TextWriter& operator<<( const std::string_view text ) noexcept
+	{
+		if ( static_cast< size_t >( _end - _position ) < text.size() ) {
+			_end = _position = nullptr;
+			return *this;
+		}
+		_position = std::copy( text.cbegin(), text.cend(), _position );
+		return *this;
+	}
+
+	template < typename Integer, typename = std::enable_if_t< std::is_integral_v< Integer > > >
+	TextWriter& operator<<( const Integer value ) noexcept
+	{
+		const auto [ position, error ] = std::to_chars( _position, _end, value );
+		if ( error != std::errc() ) {
+			_end = _position = nullptr;
+			return *this;
+		}
+		_position = position;
+		return *this;
+	}
+
+	size_t size() const noexcept
+	{
+		return _position ? static_cast< size_t >( _position - _begin ) : 0;
+	}
+
+private:
+	char* const _begin;
+	char* _position;
+	char* _end;
+};
+
+// Names of the entries of one list, when packets carry names.
+class EntryNames
+{
+public:
+	EntryNames( const StringArena* arena, const StringArena::Span* spans ) : _arena( arena ), _spans( spans )
+	{
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return nullptr != _arena;
+	}
+
+	std::string_view operator[]( const size_t slot ) const noexcept
+	{
+		return _arena ? _arena->view( _spans[ slot ] ).substr( 0, Packet::max_name_size ) : std::string_view();
+	}
+
+	// Bytes the names take in the binary layout.
+	template < typename Slots >
+	size_t binarySize( const Slots& slots ) const noexcept
+	{
+		size_t size = 0;
+		if ( _arena ) {
+			slots( [this, &size]( const size_t slot ) { size += 1 + ( *this )[ slot ].size(); } );
+		}
+		return size;
+	}
+
+private:
+	const StringArena* _arena;
+	const StringArena::Span* _spans;
+};
+
+void entryToText( TextWriter& writer, const StatisticsEntry& entry, const std::string_view name, const bool named )
+{
+	writer << "id: " << entry.id;
+	if ( named ) {
+		writer << " name: " << name;
+	}
+	writer << " amount: " << entry.amount << "\n";
+}
+
+char* entryToBinary( char* buffer, const StatisticsEntry& entry, const std::string_view name, const bool named )
+{
+	writeI64( buffer, entry.amount );
+	writeI32( buffer + sizeof( int64_t ), entry.id );
+	buffer += Packet::binary_entry_size;
+	if ( named ) {
+		writeU8( buffer++, static_cast< uint8_t >( name.size() ) );
+		buffer = std::copy( name.cbegin(), name.cend(), buffer );
+	}
+	return buffer;
+}
+
+template < typename Entries >
+char* entriesToBinary( char* buffer, const Entries& entries, const EntryNames& names )
+{
+	for ( size_t slot = 0; slot < entries.size(); ++slot ) {
+		buffer = entryToBinary( buffer, *( entries.cbegin() + slot ), names[ slot ], static_cast< bool >( names ) );
+	}
+	return buffer;
+}
+
+template < typename Entries >
+auto allSlots( const Entries& entries )
+{
+	return [&entries]( const auto& function ) {
+		for ( size_t slot = 0; slot < entries.size(); ++slot ) {
+			function( slot );
+		}
+	};
+}
+
+bool sameEntry( const StatisticsEntry& lhs, const StatisticsEntry& rhs ) noexcept
+{
+	return lhs.amount == rhs.amount && lhs.id == rhs.id;
+}
+
+template < typename Entries >
+bool sameEntries( const Entries& lhs, const Entries& rhs ) noexcept
+{
+	return std::equal( lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), sameEntry );
+}
+
+bool sameName( const StringArena::Span& lhs, const StringArena::Span& rhs ) noexcept
+{
+	return lhs.offset == rhs.offset && lhs.size == rhs.size;
+}
+
+// A renamed user gets a new span, so comparing spans finds renames; spans are empty without names.
+template < typename Names >
+bool sameNames( const Names& lhs, const Names& rhs, const size_t count ) noexcept
+{
+	return std::equal( lhs.cbegin(), lhs.cbegin() + count, rhs.cbegin(), sameName );
+}
+
+// Calls function( slot ) for every slot of entries that differs from base, in its entry or its name.
+template < typename Entries, typename Names >
+auto changedSlots( const Entries& entries, const Names& names, const Entries& base, const Names& base_names )
 {
-	auto add_user_to_packet = [&out]( const auto& value ) {
-		const auto [ amount, id ] = value;
-		out << "\tid: " << id << " amount: " << amount << "\n";
+	return [&entries, &names, &base, &base_names]( const auto& function ) {
+		for ( size_t slot = 0; slot < entries.size(); ++slot ) {
+			if ( slot >= base.size() || !sameEntry( *( entries.cbegin() + slot ), *( base.cbegin() + slot ) )
+			     || !sameName( names[ slot ], base_names[ slot ] ) ) {
+				function( slot );
+			}
+		}
 	};
+}
 
-	out << "id: " << packet.user << " position: " << packet.position << "\n";
-	out << "top: \n";
-	std::for_each( packet.top.cbegin(), packet.top.cend(), add_user_to_packet );
+template < typename Slots >
+size_t slotsCount( const Slots& slots )
+{
+	size_t count = 0;
+	slots( [&count]( size_t ) { ++count; } );
+	return count;
+}
 
-	out << "near: \n";
-	std::for_each( packet.near.cbegin(), packet.near.cend(), add_user_to_packet );
+template < typename Entries, typename Slots >
+char* changedEntriesToBinary( char* buffer, const Entries& entries, const Slots& slots, const EntryNames& names )
+{
+	writeU8( buffer++, static_cast< uint8_t >( slotsCount( slots ) ) );
+	slots( [&]( const size_t slot ) {
+		writeU8( buffer++, static_cast< uint8_t >( slot ) );
+		buffer = entryToBinary( buffer, *( entries.cbegin() + slot ), names[ slot ], static_cast< bool >( names ) );
+	} );
+	return buffer;
+}
 
-	return out;
+uint8_t binaryFlags( const bool delta, const EntryNames& names )
+{
+	return ( delta ? Packet::binary_delta_flag : 0 ) | ( names ? Packet::binary_names_flag : 0 );
+}
 }
 
-PacketsHandler::PacketsHandler( const std::string_view address, const uint16_t port )
-		: _socket( createSocket() ), _sockaddr( getRemoteSockaddr( address, port ) )
+size_t Packet::toText( char* buffer, const size_t size, const StringArena* names ) const noexcept
 {
+	TextWriter writer( buffer, size );
+	const EntryNames top_names( names, top.names.data() );
+	const EntryNames near_names( names, this->near_names.data() );
+
+	writer << "id: " << user << " position: " << position << "\n";
+	writer << "top: \n";
+	allSlots( top.entries )( [&]( const size_t slot ) {
+		writer << "\t";
+		entryToText( writer, *( top.entries.cbegin() + slot ), top_names[ slot ], names );
+	} );
+
+	writer << "near: \n";
+	allSlots( near )( [&]( const size_t slot ) {
+		writer << "\t";
+		entryToText( writer, *( near.cbegin() + slot ), near_names[ slot ], names );
+	} );
+
+	return writer.size();
+}
+
+size_t Packet::toBinary( char* buffer, const size_t size, const StringArena* names ) const noexcept
+{
+	const EntryNames top_names( names, top.names.data() );
+	const EntryNames near_names( names, this->near_names.data() );
+	const auto length = binary_header_size + ( top.entries.size() + near.size() ) * binary_entry_size
+	                    + top_names.binarySize( allSlots( top.entries ) ) + near_names.binarySize( allSlots( near ) );
+	if ( size < length ) {
+		return 0;
+	}
+
+	writeU8( buffer, binary_version );
+	writeU8( buffer + 1, static_cast< uint8_t >( top.entries.size() ) );
+	writeU8( buffer + 2, static_cast< uint8_t >( near.size() ) );
+	writeU8( buffer + 3, binaryFlags( false, top_names ) );
+	writeI32( buffer + 4, user );
+	writeU64( buffer + 8, position );
+	writeU64( buffer + 16, top.version );
+	entriesToBinary( entriesToBinary( buffer + binary_header_size, top.entries, top_names ), near, near_names );
+	return length;
+}
+
+size_t Packet::toTextDelta( const Packet& base, char* buffer, const size_t size, const StringArena* names ) const noexcept
+{
+	TextWriter writer( buffer, size );
+	const EntryNames top_names( names, top.names.data() );
+	const EntryNames near_names( names, this->near_names.data() );
+
+	writer << "delta id: " << user << " position: " << static_cast< int64_t >( position - base.position ) << "\n";
+	writer << "top: " << top.entries.size() << "\n";
+	changedSlots( top.entries, top.names, base.top.entries, base.top.names )( [&]( const size_t slot ) {
+		writer << "\t" << slot << ": ";
+		entryToText( writer, *( top.entries.cbegin() + slot ), top_names[ slot ], names );
+	} );
+
+	writer << "near: " << near.size() << "\n";
+	changedSlots( near, this->near_names, base.near, base.near_names )( [&]( const size_t slot ) {
+		writer << "\t" << slot << ": ";
+		entryToText( writer, *( near.cbegin() + slot ), near_names[ slot ], names );
+	} );
+
+	return writer.size();
+}
+
+size_t Packet::toBinaryDelta( const Packet& base, char* buffer, const size_t size, const StringArena* names ) const noexcept
+{
+	const EntryNames top_names( names, top.names.data() );
+	const EntryNames near_names( names, this->near_names.data() );
+	const auto top_slots = changedSlots( top.entries, top.names, base.top.entries, base.top.names );
+	const auto near_slots = changedSlots( near, this->near_names, base.near, base.near_names );
+	const auto length = binary_header_size + 2 + ( slotsCount( top_slots ) + slotsCount( near_slots ) ) * ( 1 + binary_entry_size )
+	                    + top_names.binarySize( top_slots ) + near_names.binarySize( near_slots );
+	if ( size < length ) {
+		return 0;
+	}
+
+	writeU8( buffer, binary_version );
+	writeU8( buffer + 1, static_cast< uint8_t >( top.entries.size() ) );
+	writeU8( buffer + 2, static_cast< uint8_t >( near.size() ) );
+	writeU8( buffer + 3, binaryFlags( true, top_names ) );
+	writeI32( buffer + 4, user );
+	writeI64( buffer + 8, static_cast< int64_t >( position - base.position ) );
+	writeU64( buffer + 16, top.version );
+	changedEntriesToBinary( changedEntriesToBinary( buffer + binary_header_size, top.entries, top_slots, top_names ), near, near_slots, near_names );
+	return length;
+}
+
+bool Packet::sameView( const Packet& other ) const noexcept
+{
+	return position == other.position && sameEntries( top.entries, other.top.entries ) && sameEntries( near, other.near )
+	       && sameNames( top.names, other.top.names, top.entries.size() ) && sameNames( near_names, other.near_names, near.size() );
+}
+
+std::ostream& operator<<( std::ostream& out, const Packet& packet )
+{
+	thread_local std::array< char, Packet::max_text_size > buffer;
+	return out.write( buffer.data(), static_cast< std::streamsize >( packet.toText( buffer.data(), buffer.size() ) ) );
+}
+
+Outbox::Outbox( const size_t capacity ) : _capacity( std::max< size_t >( 1, capacity ) )
+{
+}
+
+void Outbox::push( Packet&& packet )
+{
+	if ( _sources.empty() || _sources.back().broadcast != 0 || _sources.back().cursor > 0 ) {
+		_sources.push_back( Source{{}, 0, _sequence, 0} );
+	}
+
+	_latest[ packet.user ] = _sequence++;
+	_sources.back().packets.push_back( std::move( packet ) );
+	++_size;
+	trim();
+}
+
+void Outbox::push( std::vector< Packet >&& packets, const uint64_t broadcast )
+{
+	if ( packets.empty() ) {
+		return;
+	}
+
+	for ( size_t i = 0; i < packets.size(); ++i ) {
+		_latest[ packets[ i ].user ] = _sequence + i;
+	}
+	_sources.push_back( Source{std::move( packets ), 0, _sequence, broadcast} );
+	_sequence += _sources.back().packets.size();
+	_size += _sources.back().packets.size();
+	trim();
+}
+
+bool Outbox::empty() const noexcept
+{
+	return _sources.empty();
+}
+
+uint64_t Outbox::size() const noexcept
+{
+	return _queued.load();
+}
+
+uint64_t Outbox::coalesced() const noexcept
+{
+	return _coalesced.load();
+}
+
+uint64_t Outbox::dropped() const noexcept
+{
+	return _dropped.load();
+}
+
+bool Outbox::release( const Event::User user, const uint64_t sequence )
+{
+	const auto it = _latest.find( user );
+	if ( it == _latest.end() || it->second != sequence ) {
+		_coalesced.add();
+		return false;
+	}
+	_latest.erase( it );
+	return true;
+}
+
+void Outbox::advance()
+{
+	--_size;
+	if ( ++_sources.front().cursor == _sources.front().packets.size() ) {
+		_sources.pop_front();
+	}
+}
+
+void Outbox::trim()
+{
+	while ( _size > _capacity ) {
+		const auto& source = _sources.front();
+		if ( release( source.packets[ source.cursor ].user, source.first_sequence + source.cursor ) ) {
+			_dropped.add();
+		}
+		advance();
+	}
+	_queued.set( _size );
+}
+
+PacketsHandler::PacketsHandler( const std::string_view address, const uint16_t port, const PacketsHandlerConfig& config )
+		: _unhandled_packets( config.queue_capacity, &_doorbell )
+		, _broadcasts( broadcasts_capacity, &_doorbell )
+		, _outbox( config.outbox_capacity )
+		, _socket( createSocket() )
+		, _sockaddr( getRemoteSockaddr( address, port ) )
+		, _batch( std::max< size_t >( 1, config.batch_size ), max_datagram_size )
+		, _direct( config.direct )
+		, _binary( config.binary )
+		, _keyframe_interval( config.keyframe_interval )
+		, _datagram_users( _keyframe_interval > 0 ? _batch.capacity() : 0 )
+{
+	if ( _direct ) {
+		setNonBlocking( _socket );
+	}
+
+	if ( config.io_uring ) {
+		_ring = IoUring::create( static_cast< unsigned >( _batch.capacity() ) );
+		if ( _ring && 0 != connect( _socket, reinterpret_cast< const struct sockaddr* >( &_sockaddr ), sizeof( _sockaddr ) ) ) {
+			_ring.reset();
+		}
+	}
 }
 
 PacketsHandler::~PacketsHandler()
 {
 	close( _socket );
+
+	if ( _send_failures.load() > 0 ) {
+		std::cerr << "dropped " << _send_failures.load() << " datagrams on a full socket buffer\n";
+	}
+
+	if ( _outbox.coalesced() > 0 || _outbox.dropped() > 0 ) {
+		std::cerr << "replaced " << _outbox.coalesced() << " waiting packets with newer ones, dropped " << _outbox.dropped()
+		          << " behind a slow socket\n";
+	}
+
+	if ( _keyframe_interval > 0 ) {
+		std::cerr << "sent " << _deltas << " broadcast deltas, skipped " << _unchanged << " unchanged views\n";
+	}
+
+	if ( _ring ) {
+		std::cerr << "sent " << _ring_datagrams << " datagrams in " << _ring->calls() << " calls with io_uring\n";
+		return;
+	}
+	std::cerr << "sent " << _batch.datagrams() << " datagrams in " << _batch.calls() << " calls, average batch fill "
+	          << _batch.averageFill() << "/" << _batch.capacity() << "\n";
 }
 
 void PacketsHandler::put( std::vector< Packet >&& packets )
 {
-	std::unique_lock lock( _mutex );
-	_unhandled_packets.assign( std::move_iterator( packets.begin() ), std::move_iterator( packets.end() ) );
-	_condition_variable.notify_one();
+	for ( auto& packet : packets ) {
+		put( std::move( packet ) );
+	}
+	packets.clear();
 }
 
 void PacketsHandler::put( Packet&& packet )
 {
-	std::unique_lock lock( _mutex );
-	_unhandled_packets.push_back( std::move( packet ) );
-	_condition_variable.notify_one();
+	if ( _direct ) {
+		write( packet );
+		return;
+	}
+	_unhandled_packets.push( std::move( packet ) );
+}
+
+void PacketsHandler::putBroadcast( std::vector< Packet >&& packets )
+{
+	if ( _direct ) {
+		writeBroadcast( packets );
+		packets.clear();
+		return;
+	}
+	_broadcasts.push( std::move( packets ) );
+}
+
+void PacketsHandler::setNames( const StringArena* names )
+{
+	_names = names;
 }
 
 void PacketsHandler::proccesing()
 {
-	_stopped.store( false );
-	while ( pop() ) {
-		std::ostringstream ss;
-		ss << _processing_packet;
+	const auto ready = [this] { return !_outbox.empty() || !_unhandled_packets.empty() || !_broadcasts.empty(); };
+	while ( _doorbell.wait( ready ) ) {
+		_unhandled_packets.drain( [this]( Packet&& packet ) { _outbox.push( std::move( packet ) ); } );
+		_broadcasts.drain( [this]( std::vector< Packet >&& packets ) { _outbox.push( std::move( packets ), ++_broadcasts_put ); } );
+
+		// One batch at a time, so that packets put in the meantime still replace waiting ones.
+		_outbox.pop( [this]( const Packet& packet, const uint64_t broadcast ) { write( packet, broadcast ); }, _batch.capacity() );
+		flush();
+	}
+}
+
+void PacketsHandler::writeMetrics( MetricsWriter& writer ) const
+{
+	writer.gauge( "packets.queued", _unhandled_packets.size() );
+	writer.gauge( "packets.broadcasts_queued", _broadcasts.size() );
+	writer.gauge( "packets.outbox", _outbox.size() );
+	writer.counter( "packets.sent", _sent.load() );
+	writer.counter( "packets.send_failures", _send_failures.load() );
+	writer.counter( "packets.coalesced", _outbox.coalesced() );
+	writer.counter( "packets.outbox_dropped", _outbox.dropped() );
+	writer.histogram( "packets.send", _send_timer.histogram() );
+}
+
+void PacketsHandler::flush()
+{
+	if ( _pending > 0 ) {
+		send( _pending );
+		_pending = 0;
+	}
+}
+
+void PacketsHandler::write( const Packet& packet, const uint64_t broadcast )
+{
+	if ( broadcast != 0 ) {
+		if ( broadcast != _broadcast ) {
+			startBroadcast( broadcast );
+		}
+		++_broadcast_size;
+	}
+
+	if ( 0 == _keyframe_interval ) {
+		serialize( packet, nullptr, _pending++ );
+	}
+	else {
+		// Packets sent outside of broadcasts, on connect, are always keyframes.
+		const auto [ it, inserted ] = _sent_views.try_emplace( packet.user );
+		auto& view = it->second;
+		view.broadcast = _broadcast;
+
+		const Packet* base = nullptr;
+		if ( broadcast != 0 && !inserted && ++view.since_keyframe < _keyframe_interval ) {
+			if ( packet.sameView( view.packet ) ) {
+				++_unchanged;
+				return;
+			}
+			base = &view.packet;
+			++_deltas;
+		}
+		else {
+			view.since_keyframe = 0;
+		}
+
+		_datagram_users[ _pending ] = packet.user;
+		serialize( packet, base, _pending++ );
+		view.packet = packet;
+	}
+
+	if ( _pending == _batch.capacity() ) {
+		flush();
+	}
+}
+
+void PacketsHandler::writeBroadcast( const std::vector< Packet >& packets )
+{
+	const auto broadcast = ++_broadcasts_put;
+	for ( const auto& packet : packets ) {
+		write( packet, broadcast );
+	}
+}
 
-		send( ss.str() );
+void PacketsHandler::startBroadcast( const uint64_t broadcast )
+{
+	// Views of users that were not in the previous broadcast belong to disconnected users.
+	if ( _broadcast != 0 && _sent_views.size() > 2 * _broadcast_size ) {
+		for ( auto it = _sent_views.begin(); it != _sent_views.end(); ) {
+			it = it->second.broadcast == _broadcast ? std::next( it ) : _sent_views.erase( it );
+		}
 	}
+	_broadcast = broadcast;
+	_broadcast_size = 0;
 }
 
 void PacketsHandler::stopProcessing()
 {
-	_stopped.store( true );
-	_condition_variable.notify_one();
+	_doorbell.close();
 }
 
-bool PacketsHandler::pop()
+void PacketsHandler::serialize( const Packet& packet, const Packet* base, const size_t index )
 {
-	std::unique_lock lock( _mutex );
-	_condition_variable.wait( lock, [this] { return _stopped.load() || !_unhandled_packets.empty(); } );
+	auto* buffer = _batch.buffer( index );
+	const auto buffer_size = _batch.bufferSize();
+	size_t size = 0;
+	if ( base ) {
+		size = _binary ? packet.toBinaryDelta( *base, buffer, buffer_size, _names ) : packet.toTextDelta( *base, buffer, buffer_size, _names );
+	}
+	else {
+		size = _binary ? packet.toBinary( buffer, buffer_size, _names ) : packet.toText( buffer, buffer_size, _names );
+	}
+	_batch.setDatagramSize( index, size );
+}
 
-	if ( !_stopped.load() ) {
-		_processing_packet = std::move( _unhandled_packets.front() );
-		_unhandled_packets.pop_front();
+void PacketsHandler::send( const size_t count )
+{
+	_send_timer.measure( [this, count] {
+		if ( _ring && sendRing( count ) ) {
+			return;
+		}
+		const auto sent = _batch.send( _socket, _sockaddr, count );
+		_sent.add( sent );
+		_send_failures.add( count - sent );
+		for ( auto i = sent; i < count; ++i ) {
+			forgetView( i );
+		}
+	} );
+}
+
+// Submits the whole batch with one io_uring_enter and waits for it, since the buffers are reused next.
+// Plain sends: writing from the batch registered as a fixed buffer was measured no faster.
+bool PacketsHandler::sendRing( const size_t count )
+{
+	for ( size_t i = 0; i < count; ++i ) {
+		auto* sqe = _ring->submission();
+		if ( !sqe ) {
+			// Nothing of this batch reached the kernel, the caller sends all of it another way.
+			_ring->discardUnsubmitted();
+			return false;
+		}
+		const auto data = _batch.datagram( i );
+		sqe->opcode = IORING_OP_SEND;
+		sqe->fd = _socket;
+		sqe->addr = reinterpret_cast< uint64_t >( data.data() );
+		sqe->len = static_cast< uint32_t >( data.size() );
+		sqe->user_data = i;
 	}
 
-	return !_stopped.load();
+	size_t submitted = count;
+	size_t completed = 0;
+	while ( completed < submitted ) {
+		if ( _ring->submit( static_cast< unsigned >( submitted - completed ) ) < 0 && EINTR != errno ) {
+			// Entries left in the ring would later point at buffers holding other datagrams, so the
+			// ones the kernel did not take are lost; the ones it took are still waited for.
+			const auto discarded = _ring->discardUnsubmitted();
+			if ( 0 == discarded ) {
+				_send_failures.add( submitted - completed );
+				_ring.reset();
+				for ( size_t i = 0; i < count; ++i ) {
+					forgetView( i );
+				}
+				return true;
+			}
+			_send_failures.add( discarded );
+			for ( auto i = submitted - discarded; i < submitted; ++i ) {
+				forgetView( i );
+			}
+			submitted -= discarded;
+		}
+		completed += _ring->complete( [this]( const struct io_uring_cqe& cqe ) {
+			if ( cqe.res >= 0 ) {
+				++_ring_datagrams;
+				_sent.add();
+			}
+			else {
+				_send_failures.add();
+				forgetView( static_cast< size_t >( cqe.user_data ) );
+			}
+		} );
+	}
+	return true;
 }
 
-void PacketsHandler::send( const std::string_view data )
+void PacketsHandler::forgetView( const size_t index )
 {
-	sendto( _socket, data.data(), data.size(), 0, reinterpret_cast< const struct sockaddr* >( &_sockaddr ), sizeof( _sockaddr ) );
+	if ( _keyframe_interval > 0 ) {
+		_sent_views.erase( _datagram_users[ index ] );
+	}
 }
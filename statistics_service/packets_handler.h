@@ -1,51 +1,244 @@
 #pragma once
 
-#include <atomic>
-#include <condition_variable>
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <arpa/inet.h>
 
+#include <libs/datagram_batch.h>
+#include <libs/event.h>
+#include <libs/spsc_queue.h>
+#include <libs/string_arena.h>
+#include <libs/uring.h>
+
+#include "metrics.h"
 #include "statistics.h"
 
+struct TopStatistic
+{
+	static constexpr size_t capacity = 10;
+
+	uint64_t version;
+	StatisticsEntries< capacity > entries;
+	// Filled only when packets carry names.
+	std::array< StringArena::Span, capacity > names;
+};
+
 struct Packet
 {
+	static constexpr size_t neighbors_count = 10;
+
 	Event::User user;
 	size_t position;
-	SortedStatistic top;
-	SortedStatistic near;
+	TopStatistic top;
+	StatisticsEntries< 2 * neighbors_count + 1 > near;
+	std::array< StringArena::Span, 2 * neighbors_count + 1 > near_names;
+
+	// "id: <user> position: <position>\n", then "top: \n" and "near: \n", each followed by
+	// "\tid: <id> amount: <amount>\n" lines.
+	static constexpr size_t max_text_size = 47 + 6 + 7 + ( TopStatistic::capacity + 2 * neighbors_count + 1 ) * 46;
+
+	// Binary layout, little-endian: u8 version, u8 top count, u8 near count, u8 flags, i32 user,
+	// u64 position, u64 top version, then i64 amount + i32 id for every top and near entry.
+	static constexpr uint8_t binary_version = 1;
+	static constexpr size_t binary_header_size = 24;
+	static constexpr size_t binary_entry_size = 12;
+	static constexpr size_t max_binary_size = binary_header_size + ( TopStatistic::capacity + 2 * neighbors_count + 1 ) * binary_entry_size;
+
+	// Delta against a view the client already has. Text: "delta id: <user> position: <change>\n", then
+	// "top: <count>\n" and "near: <count>\n", each followed by "\t<slot>: id: <id> amount: <amount>\n"
+	// lines for the slots that changed. Binary: the header above with binary_delta_flag set and the
+	// position change as i64, then u8 changed top slots, u8 slot + i64 amount + i32 id for each, and
+	// the same for near.
+	static constexpr uint8_t binary_delta_flag = 1;
+	static constexpr size_t max_text_delta_size = 54 + 8 + 9 + ( TopStatistic::capacity + 2 * neighbors_count + 1 ) * 50;
+	static constexpr size_t max_binary_delta_size = binary_header_size + 2 + ( TopStatistic::capacity + 2 * neighbors_count + 1 ) * 13;
+
+	// With names, every text entry gets " name: <name>" after its id and every binary entry is followed
+	// by u8 name size and the name, with binary_names_flag set.
+	static constexpr uint8_t binary_names_flag = 2;
+	static constexpr size_t max_name_size = EventName::capacity;
+	static constexpr size_t max_names_size = ( TopStatistic::capacity + 2 * neighbors_count + 1 ) * ( 7 + max_name_size );
+
+	// All return the number of bytes written, or 0 when the buffer is too small. Names are written
+	// when the arena holding them is given.
+	size_t toText( char* buffer, const size_t size, const StringArena* names = nullptr ) const noexcept;
+	size_t toBinary( char* buffer, const size_t size, const StringArena* names = nullptr ) const noexcept;
+	size_t toTextDelta( const Packet& base, char* buffer, const size_t size, const StringArena* names = nullptr ) const noexcept;
+	size_t toBinaryDelta( const Packet& base, char* buffer, const size_t size, const StringArena* names = nullptr ) const noexcept;
+
+	// Same position, entries and names, whatever the top version.
+	bool sameView( const Packet& other ) const noexcept;
 
 	friend std::ostream& operator<<( std::ostream& out, const Packet& packet );
 };
 
+static_assert( std::is_trivially_copyable_v< Packet > );
+
+// Packets waiting for the socket, in arrival order. A newer packet for a user replaces the one still
+// waiting, so a slow socket delays ratings but never sends stale ones; beyond capacity the oldest
+// waiting packets are dropped.
+class Outbox
+{
+public:
+	explicit Outbox( const size_t capacity );
+
+	void push( Packet&& packet );
+	// broadcast numbers the broadcast the packets belong to.
+	void push( std::vector< Packet >&& packets, const uint64_t broadcast );
+
+	// Calls write( packet, broadcast ) for at most max_count packets, broadcast being 0 for packets
+	// pushed on their own. Returns the number of packets written.
+	template < typename Writer >
+	size_t pop( Writer&& write, const size_t max_count )
+	{
+		size_t count = 0;
+		while ( count < max_count && !_sources.empty() ) {
+			const auto& source = _sources.front();
+			const auto& packet = source.packets[ source.cursor ];
+			if ( release( packet.user, source.first_sequence + source.cursor ) ) {
+				write( packet, source.broadcast );
+				++count;
+			}
+			advance();
+		}
+		_queued.set( _size );
+		return count;
+	}
+
+	bool empty() const noexcept;
+
+	// Safe to call from any thread.
+	uint64_t size() const noexcept;
+	uint64_t coalesced() const noexcept;
+	uint64_t dropped() const noexcept;
+
+private:
+	// Packets pushed one by one share a source until the first of them is written.
+	struct Source
+	{
+		std::vector< Packet > packets;
+		size_t cursor;
+		uint64_t first_sequence;
+		uint64_t broadcast;
+	};
+
+	// Whether the packet is still the latest one for the user; forgets it either way.
+	bool release( const Event::User user, const uint64_t sequence );
+	void advance();
+	void trim();
+
+	const size_t _capacity;
+	std::deque< Source > _sources;
+	std::unordered_map< Event::User, uint64_t > _latest;
+	size_t _size = 0;
+	uint64_t _sequence = 0;
+
+	Gauge _queued;
+	Counter _coalesced;
+	Counter _dropped;
+};
+
+struct PacketsHandlerConfig
+{
+	size_t batch_size = 1;
+	size_t queue_capacity = 16 * 1024;
+	bool io_uring = false;
+	bool binary = false;
+	// Packets are serialized and sent by the thread that puts them, on a non-blocking socket, and
+	// flush() sends a partly filled batch; no queue or processing thread is involved.
+	bool direct = false;
+	// When not zero, broadcasts are sent as deltas against the last packet sent to the user, with a
+	// full packet every keyframe_interval broadcasts and after a datagram to the user could not be
+	// sent; unchanged views are not sent at all.
+	size_t keyframe_interval = 0;
+	// Packets waiting for the socket at most, see Outbox.
+	size_t outbox_capacity = 1024 * 1024;
+};
+
 class PacketsHandler
 {
 public:
-	PacketsHandler( const std::string_view address, const uint16_t port );
+	PacketsHandler( const std::string_view address, const uint16_t port, const PacketsHandlerConfig& config = {} );
 	~PacketsHandler();
 
 	void put( std::vector< Packet >&& packets );
 	void put( Packet&& packet );
 
+	void putBroadcast( std::vector< Packet >&& packets );
+
+	// Packets are sent with the names of their entries, read from the arena while serializing.
+	void setNames( const StringArena* names );
+
 	void proccesing();
 
 	void stopProcessing();
 
+	void flush();
+
+	// Queued packets, sent and failed datagrams and the time of a send call; safe to call from any
+	// thread.
+	void writeMetrics( MetricsWriter& writer ) const;
+
 private:
-	bool pop();
+	static constexpr size_t max_datagram_size = std::max( { Packet::max_text_size,
+	                                                         Packet::max_binary_size,
+	                                                         Packet::max_text_delta_size,
+	                                                         Packet::max_binary_delta_size } )
+	                                            + Packet::max_names_size;
+	static constexpr size_t broadcasts_capacity = 4;
+
+	struct SentView
+	{
+		Packet packet;
+		size_t since_keyframe = 0;
+		uint64_t broadcast = 0;
+	};
 
-	void send( const std::string_view data );
+	// broadcast numbers the broadcast the packet belongs to, 0 for packets sent on their own.
+	void write( const Packet& packet, const uint64_t broadcast = 0 );
+	void writeBroadcast( const std::vector< Packet >& packets );
+	void startBroadcast( const uint64_t broadcast );
+	void serialize( const Packet& packet, const Packet* base, const size_t index );
 
-	std::atomic< bool > _stopped;
-	std::mutex _mutex;
-	std::condition_variable _condition_variable;
+	void send( const size_t count );
+	bool sendRing( const size_t count );
+	// The next packet of the user of a datagram that was not sent is a keyframe again.
+	void forgetView( const size_t index );
 
-	std::deque< Packet > _unhandled_packets;
-	Packet _processing_packet;
+	Doorbell _doorbell;
+	SpscQueue< Packet > _unhandled_packets;
+	SpscQueue< std::vector< Packet > > _broadcasts;
+	Outbox _outbox;
+	uint64_t _broadcasts_put = 0;
 
 	const int _socket;
 	const struct sockaddr_in _sockaddr;
+	DatagramBatch _batch;
+	size_t _pending = 0;
+	const bool _direct;
+	const bool _binary;
+	const StringArena* _names = nullptr;
+	Counter _sent;
+	Counter _send_failures;
+	StageTimer _send_timer;
+
+	std::unique_ptr< IoUring > _ring;
+	uint64_t _ring_datagrams = 0;
+
+	const size_t _keyframe_interval;
+	std::unordered_map< Event::User, SentView > _sent_views;
+	std::vector< Event::User > _datagram_users;
+	uint64_t _broadcast = 0;
+	size_t _broadcast_size = 0;
+	uint64_t _deltas = 0;
+	uint64_t _unchanged = 0;
 };
@@ -0,0 +1,82 @@
+#include "reactor.h"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+Reactor::Reactor( EventsHandler& events_handler,
+                  PacketsHandler& packets_handler,
+                  Receiver& receiver,
+                  const std::chrono::milliseconds broadcast_period )
+    : _events_handler( events_handler )
+    , _packets_handler( packets_handler )
+    , _receiver( receiver )
+    , _epoll( epoll_create1( 0 ) )
+    , _timer( timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK ) )
+{
+	if ( _epoll < 0 || _timer < 0 ) {
+		std::cerr << "Cannot create the reactor epoll and timer descriptors.\n";
+		return;
+	}
+
+	struct itimerspec period{};
+	period.it_interval.tv_sec = static_cast< time_t >( broadcast_period.count() / 1000 );
+	period.it_interval.tv_nsec = static_cast< long >( broadcast_period.count() % 1000 * 1000000 );
+	period.it_value = period.it_interval;
+	if ( timerfd_settime( _timer, 0, &period, nullptr ) != 0 ) {
+		std::cerr << "Cannot start the broadcast timer.\n";
+		return;
+	}
+
+	for ( const auto fd : {_receiver.socket(), _timer} ) {
+		struct epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if ( epoll_ctl( _epoll, EPOLL_CTL_ADD, fd, &event ) != 0 ) {
+			std::cerr << "Cannot add descriptor " << fd << " to the reactor epoll.\n";
+			return;
+		}
+	}
+	_open = true;
+}
+
+Reactor::~Reactor()
+{
+	if ( _timer >= 0 ) {
+		close( _timer );
+	}
+	if ( _epoll >= 0 ) {
+		close( _epoll );
+	}
+}
+
+bool Reactor::isOpen() const noexcept
+{
+	return _open;
+}
+
+void Reactor::run( const std::atomic< bool >& stopped )
+{
+	const auto handle = [this]( const Event& event ) { _events_handler.handle( event ); };
+
+	std::array< struct epoll_event, 2 > events;
+	while ( _open && !stopped.load() ) {
+		const auto ready = epoll_wait( _epoll, events.data(), static_cast< int >( events.size() ), static_cast< int >( wait_timeout.count() ) );
+		for ( int i = 0; i < ready; ++i ) {
+			if ( events[ i ].data.fd == _timer ) {
+				uint64_t expirations = 0;
+				if ( read( _timer, &expirations, sizeof( expirations ) ) > 0 ) {
+					_events_handler.broadcast();
+				}
+			}
+			else {
+				_receiver.receiveAvailable( handle );
+			}
+		}
+		_packets_handler.flush();
+	}
+}
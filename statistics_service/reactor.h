@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "events_handler.h"
+#include "packets_handler.h"
+#include "receiver.h"
+
+// Run-to-completion loop for latency-sensitive deployments: one thread waits on the input socket
+// and a timerfd with epoll, applies events inline and sends the resulting packets straight away.
+// Expects an EventsHandler with one shard and timed broadcasts and a direct PacketsHandler.
+class Reactor
+{
+public:
+	Reactor( EventsHandler& events_handler,
+	         PacketsHandler& packets_handler,
+	         Receiver& receiver,
+	         const std::chrono::milliseconds broadcast_period );
+	~Reactor();
+
+	// False when the epoll or timer setup failed; run() then returns straight away.
+	bool isOpen() const noexcept;
+
+	// Returns once stopped is set; checks it at least every wait_timeout.
+	void run( const std::atomic< bool >& stopped );
+
+private:
+	static constexpr std::chrono::milliseconds wait_timeout{100};
+
+	EventsHandler& _events_handler;
+	PacketsHandler& _packets_handler;
+	Receiver& _receiver;
+
+	const int _epoll;
+	const int _timer;
+	bool _open = false;
+};
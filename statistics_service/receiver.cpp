@@ -0,0 +1,175 @@
+#include "receiver.h"
+
+#include <cerrno>
+#include <chrono>
+#include <string>
+
+#include <linux/filter.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <libs/common.h>
+
+namespace
+{
+constexpr size_t buffer_length = 1024;
+constexpr size_t ring_buffers = 4096;
+constexpr unsigned ring_entries = 256;
+constexpr std::chrono::milliseconds receive_timeout( 100 );
+}
+
+Receiver::Receiver( const uint16_t port, const bool binary, const size_t batch_size, const bool io_uring, const bool reuse_port )
+    : _socket( createSocket() ), _binary( binary ), _batch( batch_size, buffer_length )
+{
+	if ( reuse_port ) {
+		setReusePort( _socket );
+	}
+	setReceiveTimeout( _socket, receive_timeout );
+	bindSocket( _socket, port );
+
+	if ( io_uring ) {
+		_ring = IoUring::create( ring_entries );
+		if ( _ring && !_ring->provideBuffers( ring_buffers, buffer_length ) ) {
+			_ring.reset();
+		}
+	}
+}
+
+Receiver::~Receiver()
+{
+	close( _socket );
+}
+
+bool Receiver::steerByUser( const size_t receivers )
+{
+	if ( !_binary || receivers < 2 ) {
+		return false;
+	}
+
+	// A = lowest byte of the little-endian user id; return A % receivers as the socket index.
+	struct sock_filter code[] = {
+	    {BPF_LD | BPF_B | BPF_ABS, 0, 0, static_cast< uint32_t >( Event::binary_user_offset )},
+	    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast< uint32_t >( receivers )},
+	    {BPF_RET | BPF_A, 0, 0, 0},
+	};
+	struct sock_fprog program{};
+	program.len = sizeof( code ) / sizeof( code[ 0 ] );
+	program.filter = code;
+	return 0 == setsockopt( _socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof( program ) );
+}
+
+void Receiver::run( const std::atomic< bool >& stopped, const std::function< void( const Event& event ) >& put_event )
+{
+	while ( !stopped.load() ) {
+		if ( _ring ) {
+			if ( !receiveRing( put_event ) ) {
+				_ring.reset();
+			}
+			continue;
+		}
+
+		if ( const auto received = _batch.receive( _socket ); received > 0 ) {
+			_handle_timer.measure( [&] {
+				for ( size_t i = 0; i < received; ++i ) {
+					putDatagram( _batch.datagram( i ), put_event );
+				}
+			} );
+		}
+	}
+}
+
+size_t Receiver::receiveAvailable( const std::function< void( const Event& event ) >& put_event, const size_t max_batches )
+{
+	size_t total = 0;
+	for ( size_t batch = 0; batch < max_batches; ++batch ) {
+		const auto received = _batch.receive( _socket, false );
+		for ( size_t i = 0; i < received; ++i ) {
+			putDatagram( _batch.datagram( i ), put_event );
+		}
+		total += received;
+		if ( received < _batch.capacity() ) {
+			break;
+		}
+	}
+	return total;
+}
+
+int Receiver::socket() const noexcept
+{
+	return _socket;
+}
+
+bool Receiver::usesIoUring() const noexcept
+{
+	return _ring != nullptr;
+}
+
+uint64_t Receiver::calls() const noexcept
+{
+	return _batch.calls() + ( _ring ? _ring->calls() : 0 );
+}
+
+uint64_t Receiver::datagrams() const noexcept
+{
+	return _batch.datagrams() + _ring_datagrams;
+}
+
+void Receiver::writeMetrics( MetricsWriter& writer, const std::string_view prefix ) const
+{
+	const std::string name( prefix );
+	writer.counter( name + ".datagrams", _received.load() );
+	writer.counter( name + ".malformed", _malformed.load() );
+	writer.histogram( name + ".handle_batch", _handle_timer.histogram() );
+}
+
+// Returns false when the kernel rejects the multishot receive.
+bool Receiver::receiveRing( const std::function< void( const Event& event ) >& put_event )
+{
+	if ( !_ring_armed && !armRing() ) {
+		return false;
+	}
+
+	_ring->submit( 1, receive_timeout );
+
+	bool rejected = false;
+	_ring->complete( [this, &put_event, &rejected]( const struct io_uring_cqe& cqe ) {
+		if ( cqe.res > 0 ) {
+			++_ring_datagrams;
+			putDatagram( _ring->buffer( cqe ), put_event );
+		}
+		_ring->recycle( cqe );
+
+		if ( !( cqe.flags & IORING_CQE_F_MORE ) ) {
+			_ring_armed = false;
+			rejected = rejected || ( cqe.res < 0 && -ENOBUFS != cqe.res );
+		}
+	} );
+	return !rejected;
+}
+
+bool Receiver::armRing()
+{
+	auto* sqe = _ring->submission();
+	if ( !sqe ) {
+		return false;
+	}
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = _socket;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->buf_group = IoUring::buffer_group;
+	_ring_armed = true;
+	return true;
+}
+
+void Receiver::putDatagram( const std::string_view data, const std::function< void( const Event& event ) >& put_event )
+{
+	_received.add();
+	if ( const auto event = _binary ? Event::fromBinary( data ) : Event::fromText( data ); event ) {
+		put_event( event );
+	}
+	else {
+		_malformed.add();
+	}
+}
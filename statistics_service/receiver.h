@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include <libs/datagram_batch.h>
+#include <libs/event.h>
+#include <libs/uring.h>
+
+#include "metrics.h"
+
+// Receive loop on one socket of the SO_REUSEPORT group bound to the receive port. Sockets join
+// the group in construction order, which is also their index for steerByUser().
+class Receiver
+{
+public:
+	// With io_uring the socket is read by a multishot receive into provided buffers; falls back to
+	// recvmmsg when the kernel does not support it. Only with reuse_port does the socket join the
+	// SO_REUSEPORT group, so that a single receiver does not share the port by accident.
+	Receiver( const uint16_t port, const bool binary, const size_t batch_size, const bool io_uring = false, const bool reuse_port = false );
+	~Receiver();
+
+	// Makes the kernel pick the socket for a binary event by its user id, so that events of one user
+	// always reach the same receiver in order. Applies to the first `receivers` sockets of the group.
+	bool steerByUser( const size_t receivers );
+
+	// Returns once stopped is set; checks it at least every receive_timeout.
+	void run( const std::atomic< bool >& stopped, const std::function< void( const Event& event ) >& put_event );
+
+	// Reads what is already queued on the socket, at most max_batches batches, without blocking.
+	size_t receiveAvailable( const std::function< void( const Event& event ) >& put_event, const size_t max_batches = 16 );
+
+	int socket() const noexcept;
+	bool usesIoUring() const noexcept;
+	uint64_t calls() const noexcept;
+	uint64_t datagrams() const noexcept;
+
+	// Datagrams, malformed ones and the time to parse and hand off a received batch; safe to call
+	// from any thread.
+	void writeMetrics( MetricsWriter& writer, const std::string_view prefix ) const;
+
+private:
+	bool receiveRing( const std::function< void( const Event& event ) >& put_event );
+	bool armRing();
+	void putDatagram( const std::string_view data, const std::function< void( const Event& event ) >& put_event );
+
+	const int _socket;
+	const bool _binary;
+	DatagramBatch _batch;
+
+	std::unique_ptr< IoUring > _ring;
+	bool _ring_armed = false;
+	uint64_t _ring_datagrams = 0;
+
+	Counter _received;
+	Counter _malformed;
+	StageTimer _handle_timer;
+};
@@ -0,0 +1,77 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libs/event.h>
+
+Replay::Replay( const std::string& path )
+{
+	const auto fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+	if ( fd < 0 ) {
+		return;
+	}
+
+	struct stat status{};
+	if ( fstat( fd, &status ) == 0 && status.st_size > 0 ) {
+		const auto size = static_cast< size_t >( status.st_size );
+		const auto memory = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( MAP_FAILED != memory ) {
+			madvise( memory, size, MADV_SEQUENTIAL );
+			_data = static_cast< const char* >( memory );
+			_size = size;
+		}
+	}
+	close( fd );
+}
+
+Replay::~Replay()
+{
+	if ( _data ) {
+		munmap( const_cast< char* >( _data ), _size );
+	}
+}
+
+bool Replay::isOpen() const noexcept
+{
+	return nullptr != _data;
+}
+
+size_t Replay::run( EventsHandler& events_handler, PacketsHandler& packets_handler, const std::atomic< bool >& stopped )
+{
+	size_t handled = 0;
+	size_t lines = 0;
+	const auto* end = _data + _size;
+	for ( const auto* line = _data; line < end; ++lines ) {
+		const auto* line_end = std::find( line, end, '\n' );
+		if ( line_end != line ) {
+			if ( const auto event = Event::fromText( std::string_view( line, static_cast< size_t >( line_end - line ) ) ); event ) {
+				events_handler.handle( event );
+				++handled;
+			}
+			else {
+				++_skipped;
+			}
+		}
+		line = line_end + 1;
+
+		// Counted in lines, so that a long run of malformed ones still notices a stop.
+		if ( 0 == lines % stop_check_interval && stopped.load( std::memory_order_relaxed ) ) {
+			break;
+		}
+	}
+
+	events_handler.flushConnects();
+	packets_handler.flush();
+	return handled;
+}
+
+size_t Replay::skipped() const noexcept
+{
+	return _skipped;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+#include "events_handler.h"
+#include "packets_handler.h"
+
+// Feeds a file of text events, one per line as written by generator, straight into EventsHandler
+// without sockets. The file is mapped and parsed in place, so the run measures the service alone.
+// Expects a direct PacketsHandler, the way Reactor does.
+class Replay
+{
+public:
+	explicit Replay( const std::string& path );
+	~Replay();
+
+	Replay( const Replay& ) = delete;
+	Replay& operator=( const Replay& ) = delete;
+
+	bool isOpen() const noexcept;
+
+	// Returns the number of events handled; returns early once stopped is set.
+	size_t run( EventsHandler& events_handler, PacketsHandler& packets_handler, const std::atomic< bool >& stopped );
+
+	size_t skipped() const noexcept;
+
+private:
+	static constexpr size_t stop_check_interval = 64 * 1024;
+
+	const char* _data = nullptr;
+	size_t _size = 0;
+	size_t _skipped = 0;
+};
@@ -1,17 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
-#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
 #include <libs/event.h>
 
-struct StatisticsComparator
+struct StatisticsEntry
 {
-	using value_type = std::pair< int64_t, Event::User >;
+	int64_t amount;
+	Event::User id;
+};
 
-	bool operator()( const value_type& lhs, const value_type& rhs ) const
+struct StatisticsComparator
+{
+	bool operator()( const StatisticsEntry& lhs, const StatisticsEntry& rhs ) const
 	{
 		const auto [ lhs_amount, lhs_id ] = lhs;
 		const auto [ rhs_amount, rhs_id ] = rhs;
@@ -22,5 +30,80 @@ struct StatisticsComparator
 	}
 };
 
-using Statistics = std::unordered_map< Event::User, int64_t >;
-using SortedStatistic = std::set< std::pair< int64_t, Event::User >, StatisticsComparator >;
+// Unsigned key that orders entries the way StatisticsComparator does: amount descending, then id ascending.
+struct StatisticsKey
+{
+	static constexpr size_t bytes = sizeof( int64_t ) + sizeof( Event::User );
+
+	unsigned __int128 operator()( const StatisticsEntry& entry ) const noexcept
+	{
+		const auto amount = ~( static_cast< uint64_t >( entry.amount ) ^ ( uint64_t( 1 ) << 63 ) );
+		const auto id = static_cast< uint32_t >( entry.id ) ^ ( uint32_t( 1 ) << 31 );
+		return ( static_cast< unsigned __int128 >( amount ) << 32 ) | id;
+	}
+};
+
+template < size_t Capacity >
+class StatisticsEntries
+{
+public:
+	using const_iterator = typename std::array< StatisticsEntry, Capacity >::const_iterator;
+
+	template < typename Iterator >
+	void assign( Iterator first, const size_t count ) noexcept
+	{
+		_size = static_cast< uint32_t >( std::min( count, Capacity ) );
+		std::copy_n( first, _size, _entries.begin() );
+	}
+
+	size_t size() const noexcept
+	{
+		return _size;
+	}
+
+	bool empty() const noexcept
+	{
+		return 0 == _size;
+	}
+
+	const StatisticsEntry& back() const noexcept
+	{
+		return _entries[ _size - 1 ];
+	}
+
+	const_iterator cbegin() const noexcept
+	{
+		return _entries.cbegin();
+	}
+
+	const_iterator cend() const noexcept
+	{
+		return _entries.cbegin() + _size;
+	}
+
+private:
+	uint32_t _size = 0;
+	std::array< StatisticsEntry, Capacity > _entries;
+};
+
+// Amount of a user in the given week; amounts of earlier weeks count as zero.
+struct WeeklyAmount
+{
+	int64_t amount;
+	uint32_t week;
+};
+
+using Statistics = std::unordered_map< Event::User, WeeklyAmount >;
+
+// Red-black tree augmented with subtree sizes: order_of_key() and find_by_order() are O(log n).
+using SortedStatistic = __gnu_pbds::tree< StatisticsEntry,
+                                          __gnu_pbds::null_type,
+                                          StatisticsComparator,
+                                          __gnu_pbds::rb_tree_tag,
+                                          __gnu_pbds::tree_order_statistics_node_update >;
+
+using SortedUsers = __gnu_pbds::tree< Event::User,
+                                      __gnu_pbds::null_type,
+                                      std::less< Event::User >,
+                                      __gnu_pbds::rb_tree_tag,
+                                      __gnu_pbds::tree_order_statistics_node_update >;
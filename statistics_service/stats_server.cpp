@@ -0,0 +1,68 @@
+#include "stats_server.h"
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <libs/common.h>
+
+StatsServer::StatsServer( const uint16_t port, const std::chrono::seconds log_period, Writer write )
+    : _socket( port > 0 ? createSocket() : -1 ), _log_period( log_period ), _write( std::move( write ) )
+{
+	if ( _socket >= 0 ) {
+		const auto self = getRemoteSockaddr( "127.0.0.1", port );
+		if ( bind( _socket, reinterpret_cast< const struct sockaddr* >( &self ), sizeof( self ) ) != 0 ) {
+			std::cerr << "Cannot bind the stats port " << port << ".\n";
+		}
+		setReceiveTimeout( _socket, wait_timeout );
+	}
+	_thread = std::thread( [this] { processing(); } );
+}
+
+StatsServer::~StatsServer()
+{
+	_stopped.store( true );
+	_thread.join();
+	if ( _socket >= 0 ) {
+		close( _socket );
+	}
+}
+
+void StatsServer::processing()
+{
+	// Requests and log dumps get writers of their own, so that each sees rates since its own last dump.
+	MetricsWriter request_writer;
+	MetricsWriter log_writer;
+	auto next_log = std::chrono::steady_clock::now() + _log_period;
+
+	std::array< char, max_request_size > request;
+	while ( !_stopped.load() ) {
+		if ( _socket < 0 ) {
+			std::this_thread::sleep_for( wait_timeout );
+		}
+		else {
+			struct sockaddr_in client{};
+			socklen_t client_size = sizeof( client );
+			if ( recvfrom( _socket, request.data(), request.size(), 0, reinterpret_cast< struct sockaddr* >( &client ), &client_size ) >= 0 ) {
+				std::ostringstream out;
+				request_writer.begin( out );
+				_write( request_writer );
+				const auto text = out.str();
+				sendto( _socket, text.data(), text.size(), 0, reinterpret_cast< const struct sockaddr* >( &client ), client_size );
+			}
+		}
+
+		if ( _log_period.count() > 0 && std::chrono::steady_clock::now() >= next_log ) {
+			next_log += _log_period;
+			std::ostringstream out;
+			log_writer.begin( out );
+			_write( log_writer );
+			std::cerr << out.str() << std::flush;
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "metrics.h"
+
+// Serves metrics from its own thread: any datagram to the local UDP port is answered with a dump,
+// and with a log period the dump is also written to stderr that often. Port 0 opens no socket.
+class StatsServer
+{
+public:
+	using Writer = std::function< void( MetricsWriter& writer ) >;
+
+	StatsServer( const uint16_t port, const std::chrono::seconds log_period, Writer write );
+	~StatsServer();
+
+	StatsServer( const StatsServer& ) = delete;
+	StatsServer& operator=( const StatsServer& ) = delete;
+
+private:
+	static constexpr std::chrono::milliseconds wait_timeout{100};
+	static constexpr size_t max_request_size = 64;
+
+	void processing();
+
+	const int _socket;
+	const std::chrono::seconds _log_period;
+	const Writer _write;
+
+	std::atomic< bool > _stopped{false};
+	std::thread _thread;
+};
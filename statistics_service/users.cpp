@@ -0,0 +1,25 @@
+#include "users.h"
+
+UserSet::UserSet( const size_t dense_users ) : _dense( dense_users > 0 ), _bitmap( dense_users )
+{
+}
+
+bool UserSet::insert( const Event::User user )
+{
+	return _dense ? _bitmap.insert( static_cast< size_t >( user ) ) : _users.insert( user ).second;
+}
+
+bool UserSet::erase( const Event::User user )
+{
+	return _dense ? _bitmap.erase( static_cast< size_t >( user ) ) : _users.erase( user ) > 0;
+}
+
+bool UserSet::contains( const Event::User user ) const
+{
+	return _dense ? _bitmap.contains( static_cast< size_t >( user ) ) : _users.count( user ) > 0;
+}
+
+size_t UserSet::size() const noexcept
+{
+	return _dense ? _bitmap.size() : _users.size();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <libs/event.h>
+#include <libs/rank_bitmap.h>
+
+// Set of users: a hash set, or with dense_users a bitmap over user ids in [0, dense_users).
+class UserSet
+{
+public:
+	explicit UserSet( const size_t dense_users = 0 );
+
+	bool insert( const Event::User user );
+	bool erase( const Event::User user );
+	bool contains( const Event::User user ) const;
+
+	size_t size() const noexcept;
+
+	template < typename Function >
+	void forEach( Function&& function ) const
+	{
+		if ( _dense ) {
+			_bitmap.forEach( [&function]( const size_t user ) { function( static_cast< Event::User >( user ) ); } );
+			return;
+		}
+		for ( const auto user : _users ) {
+			function( user );
+		}
+	}
+
+private:
+	const bool _dense;
+	std::unordered_set< Event::User > _users;
+	RankBitmap _bitmap;
+};
+
+// Value per user: a hash map, or with dense_users an array indexed by user ids in [0, dense_users).
+template < typename T >
+class UserMap
+{
+public:
+	explicit UserMap( const size_t dense_users = 0 ) : _dense( dense_users > 0 ), _present( dense_users )
+	{
+	}
+
+	// The user's value, value-initialized when the user was not there yet, and whether it was added.
+	std::pair< T&, bool > tryEmplace( const Event::User user )
+	{
+		if ( !_dense ) {
+			const auto [ it, inserted ] = _values.try_emplace( user );
+			return {it->second, inserted};
+		}
+
+		const auto index = static_cast< size_t >( user );
+		const auto inserted = _present.insert( user );
+		if ( index >= _dense_values.size() ) {
+			_dense_values.resize( index + 1 );
+		}
+		if ( inserted ) {
+			_dense_values[ index ] = T();
+		}
+		return {_dense_values[ index ], inserted};
+	}
+
+	const T* find( const Event::User user ) const
+	{
+		if ( _dense ) {
+			return _present.contains( user ) ? &_dense_values[ static_cast< size_t >( user ) ] : nullptr;
+		}
+		const auto it = _values.find( user );
+		return it != _values.cend() ? &it->second : nullptr;
+	}
+
+	size_t size() const noexcept
+	{
+		return _dense ? _present.size() : _values.size();
+	}
+
+	template < typename Function >
+	void forEach( Function&& function ) const
+	{
+		if ( _dense ) {
+			_present.forEach( [this, &function]( const Event::User user ) { function( user, _dense_values[ static_cast< size_t >( user ) ] ); } );
+			return;
+		}
+		for ( const auto& [ user, value ] : _values ) {
+			function( user, value );
+		}
+	}
+
+private:
+	const bool _dense;
+	std::unordered_map< Event::User, T > _values;
+	UserSet _present;
+	std::vector< T > _dense_values;
+};
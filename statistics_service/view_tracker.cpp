@@ -0,0 +1,151 @@
+#include "view_tracker.h"
+
+#include <algorithm>
+
+namespace
+{
+// Renamed users get new name spans, so a rename in the top changes it too.
+bool sameTop( const TopStatistic& lhs, const TopStatistic& rhs ) noexcept
+{
+	const auto same_entry = []( const auto& lhs_entry, const auto& rhs_entry ) {
+		return lhs_entry.amount == rhs_entry.amount && lhs_entry.id == rhs_entry.id;
+	};
+	const auto same_name = []( const auto& lhs_name, const auto& rhs_name ) {
+		return lhs_name.offset == rhs_name.offset && lhs_name.size == rhs_name.size;
+	};
+	return std::equal( lhs.entries.cbegin(), lhs.entries.cend(), rhs.entries.cbegin(), rhs.entries.cend(), same_entry )
+	       && std::equal( lhs.names.cbegin(), lhs.names.cbegin() + lhs.entries.size(), rhs.names.cbegin(), same_name );
+}
+}
+
+void DirtyRanges::markMoved( const StatisticsEntry& from, const StatisticsEntry& to )
+{
+	const auto from_key = StatisticsKey()( from );
+	const auto to_key = StatisticsKey()( to );
+	mark( std::min( from_key, to_key ), std::max( from_key, to_key ) );
+}
+
+void DirtyRanges::markInserted( const StatisticsEntry& entry )
+{
+	mark( StatisticsKey()( entry ), max_key );
+}
+
+void DirtyRanges::markEntry( const StatisticsEntry& entry )
+{
+	const auto key = StatisticsKey()( entry );
+	mark( key, key );
+}
+
+void DirtyRanges::markAll()
+{
+	_ranges.assign( 1, {0, max_key} );
+}
+
+void DirtyRanges::append( DirtyRanges& other )
+{
+	for ( const auto& [ first, last ] : other._ranges ) {
+		mark( first, last );
+	}
+	other._ranges.clear();
+}
+
+void DirtyRanges::compact()
+{
+	std::sort( _ranges.begin(), _ranges.end() );
+
+	size_t size = 0;
+	for ( const auto& range : _ranges ) {
+		if ( size > 0 && range.first <= _ranges[ size - 1 ].second ) {
+			_ranges[ size - 1 ].second = std::max( _ranges[ size - 1 ].second, range.second );
+		}
+		else {
+			_ranges[ size++ ] = range;
+		}
+	}
+	_ranges.resize( size );
+}
+
+bool DirtyRanges::intersects( const Key first, const Key last ) const
+{
+	const auto it = std::lower_bound( _ranges.cbegin(), _ranges.cend(), first, []( const auto& range, const Key key ) {
+		return range.second < key;
+	} );
+	return it != _ranges.cend() && it->first <= last;
+}
+
+bool DirtyRanges::empty() const noexcept
+{
+	return _ranges.empty();
+}
+
+void DirtyRanges::mark( const Key first, const Key last )
+{
+	_ranges.emplace_back( first, last );
+	if ( _ranges.size() < max_ranges ) {
+		return;
+	}
+
+	compact();
+	if ( _ranges.size() > max_ranges / 2 ) {
+		_ranges.front().second = std::max_element( _ranges.cbegin(), _ranges.cend(), []( const auto& lhs, const auto& rhs ) {
+			                         return lhs.second < rhs.second;
+		                         } )->second;
+		_ranges.resize( 1 );
+	}
+}
+
+ViewTracker::ViewTracker( const size_t max_silence ) : _max_silence( max_silence )
+{
+}
+
+void ViewTracker::startBroadcast( DirtyRanges&& changed, const TopStatistic& top )
+{
+	++_broadcast;
+	_changed = std::move( changed );
+	_changed.compact();
+	_top_changed = !sameTop( _top, top );
+	_top = top;
+}
+
+bool ViewTracker::needsPacket( const Event::User user )
+{
+	const auto it = _views.find( user );
+	if ( it == _views.end() || _top_changed ) {
+		return true;
+	}
+
+	// A view is only known to be current when it was checked against every broadcast since it was sent.
+	auto& view = it->second;
+	if ( view.seen + 1 != _broadcast || _broadcast - view.sent >= _max_silence || _changed.intersects( view.first, view.last ) ) {
+		return true;
+	}
+
+	view.seen = _broadcast;
+	++_skipped;
+	return false;
+}
+
+void ViewTracker::finishBroadcast( const size_t connected )
+{
+	if ( _views.size() > 2 * connected ) {
+		for ( auto it = _views.begin(); it != _views.end(); ) {
+			it = it->second.seen == _broadcast ? std::next( it ) : _views.erase( it );
+		}
+	}
+}
+
+void ViewTracker::sent( const Packet& packet )
+{
+	// The near window reaches past an end of the leaderboard when it has fewer neighbors on that side.
+	const auto& near = packet.near;
+	const auto before = std::min( Packet::neighbors_count, packet.position - 1 );
+	const auto first = near.empty() || before < Packet::neighbors_count ? 0 : StatisticsKey()( *near.cbegin() );
+	const auto last = near.size() < before + Packet::neighbors_count + 1 ? DirtyRanges::max_key : StatisticsKey()( near.back() );
+
+	_views[ packet.user ] = View{first, last, _broadcast, _broadcast};
+}
+
+uint64_t ViewTracker::skipped() const noexcept
+{
+	return _skipped;
+}
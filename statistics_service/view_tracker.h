@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <libs/event.h>
+
+#include "packets_handler.h"
+#include "statistics.h"
+
+// Ranges of the leaderboard order, as StatisticsKey values, whose entries or positions changed.
+// An update that moves an entry changes only the positions between its old and new key.
+class DirtyRanges
+{
+public:
+	using Key = unsigned __int128;
+
+	static constexpr Key max_key = ~Key( 0 );
+
+	void markMoved( const StatisticsEntry& from, const StatisticsEntry& to );
+	// A new entry shifts every position after it.
+	void markInserted( const StatisticsEntry& entry );
+	// The entry stays in place but its contents, such as the name, changed.
+	void markEntry( const StatisticsEntry& entry );
+	void markAll();
+
+	void append( DirtyRanges& other );
+
+	// Sorts and merges the ranges; intersects() requires it.
+	void compact();
+	bool intersects( const Key first, const Key last ) const;
+
+	bool empty() const noexcept;
+
+private:
+	static constexpr size_t max_ranges = 64 * 1024;
+
+	void mark( const Key first, const Key last );
+
+	std::vector< std::pair< Key, Key > > _ranges;
+};
+
+// Remembers which part of the leaderboard every user saw in the last packet sent to them, so that a
+// broadcast can leave out users whose view was not touched, for at most max_silence broadcasts.
+class ViewTracker
+{
+public:
+	explicit ViewTracker( const size_t max_silence );
+
+	void startBroadcast( DirtyRanges&& changed, const TopStatistic& top );
+	bool needsPacket( const Event::User user );
+	void finishBroadcast( const size_t connected );
+
+	void sent( const Packet& packet );
+
+	uint64_t skipped() const noexcept;
+
+private:
+	struct View
+	{
+		DirtyRanges::Key first;
+		DirtyRanges::Key last;
+		uint64_t seen;
+		uint64_t sent;
+	};
+
+	const size_t _max_silence;
+	std::unordered_map< Event::User, View > _views;
+
+	uint64_t _broadcast = 0;
+	DirtyRanges _changed;
+	bool _top_changed = true;
+	TopStatistic _top{};
+
+	uint64_t _skipped = 0;
+};